@@ -0,0 +1,360 @@
+// server/catalog.cpp
+#include "catalog.h"
+#include "stats.h"
+#include "datetime.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct CatalogEntry {
+    bool      valid  = false;   // false => recarregar do disco
+    bool      exists = false;   // START válido
+    EventInfo info;
+};
+
+static pthread_mutex_t g_mu = PTHREAD_MUTEX_INITIALIZER;
+
+static bool  g_active = false;
+static int   g_ifd    = -1;
+static pid_t g_owner  = 0;     // processo dono do inotify
+static int   g_root_wd = -1;
+
+static std::map<std::string, CatalogEntry> g_events;   // ordenado por EID (LST)
+static std::uint64_t g_version = 1;   // muda quando algo visível no LST muda
+
+// Índice por dono (LSX com owner): UID -> EIDs ordenados
+static std::map<std::string, std::set<std::string>> g_by_owner;
+static std::unordered_map<int, std::string> g_wd_eid;
+
+static const uint32_t ROOT_MASK  = IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_ONLYDIR;
+static const uint32_t EVENT_MASK = IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE | IN_DELETE |
+                                  IN_MOVED_FROM | IN_ONLYDIR;
+
+struct CatalogGuard {
+    CatalogGuard()  { ::pthread_mutex_lock(&g_mu); }
+    ~CatalogGuard() { ::pthread_mutex_unlock(&g_mu); }
+};
+
+// fork() com o mutex na mão de outra thread (shards UDP) deixava o filho
+// bloqueado para sempre
+static void atfork_prepare() { ::pthread_mutex_lock(&g_mu); }
+static void atfork_release() { ::pthread_mutex_unlock(&g_mu); }
+
+static bool is_eid_name(const char *name)
+{
+    return std::strlen(name) == 3 && name[0] != '.';
+}
+
+// só EVENT.bin e START/RES/END mudam o EventInfo
+static bool is_event_file(const char *name)
+{
+    return std::strcmp(name, "EVENT.bin") == 0 ||
+           std::strncmp(name, "START ", 6) == 0 ||
+           std::strncmp(name, "RES ", 4) == 0 ||
+           std::strncmp(name, "END ", 4) == 0;
+}
+
+// Entre a hora do evento e o END do agendador (expiry.h) o Past vem do
+// relógio, não dos ficheiros.
+static void apply_time(EventInfo &ev)
+{
+    if (!ev.has_end_file && ev.state != EventState::Past &&
+        dt_now() > ev.event_ts) {
+        ev.state = EventState::Past;
+    }
+}
+
+// Campos que aparecem no LST (RLS)
+static bool same_listing(const CatalogEntry &a, const CatalogEntry &b)
+{
+    if (a.exists != b.exists) return false;
+    if (!a.exists) return true;
+    return a.info.name == b.info.name && a.info.state == b.info.state &&
+           a.info.event_date == b.info.event_date &&
+           a.info.has_end_file == b.info.has_end_file;
+}
+
+static void unindex(const std::string &eid, const CatalogEntry &e)
+{
+    if (!e.exists) return;
+    auto it = g_by_owner.find(e.info.owner_uid);
+    if (it == g_by_owner.end()) return;
+    it->second.erase(eid);
+    if (it->second.empty()) g_by_owner.erase(it);
+}
+
+static void reload(const std::string &eid, CatalogEntry &e)
+{
+    const CatalogEntry before = e;
+    e.exists = load_event_disk(eid, e.info);
+    e.valid  = true;
+    // primeira leitura: só muda o LST se o evento existir
+    if (before.valid ? !same_listing(before, e) : e.exists) ++g_version;
+
+    if (before.valid) unindex(eid, before);
+    if (e.exists) g_by_owner[e.info.owner_uid].insert(eid);
+    stats_catalog(false);
+}
+
+// Remove o evento do catálogo (diretoria apagada)
+static void forget(const std::string &eid)
+{
+    auto it = g_events.find(eid);
+    if (it == g_events.end()) return;
+    if (it->second.valid) unindex(eid, it->second);
+    g_events.erase(it);
+    ++g_version;
+}
+
+static void watch_event_dir(const std::string &eid)
+{
+    int wd = ::inotify_add_watch(g_ifd, event_dir(eid).c_str(), EVENT_MASK);
+    if (wd >= 0) g_wd_eid[wd] = eid;
+}
+
+// (re)lê EVENTS/ todo; watches primeiro, ficheiros depois
+static void full_scan()
+{
+    g_events.clear();
+    g_by_owner.clear();
+    ++g_version;
+
+    DIR *dir = ::opendir("EVENTS");
+    if (!dir) return;
+
+    struct dirent *ent;
+    while ((ent = ::readdir(dir)) != nullptr) {
+        if (!is_eid_name(ent->d_name)) continue;
+        watch_event_dir(ent->d_name);
+        g_events[ent->d_name];
+    }
+    ::closedir(dir);
+
+    for (auto &kv : g_events) reload(kv.first, kv.second);
+}
+
+// Esvazia o inotify e recarrega os eventos que mudaram. Com g_mu.
+static void drain_locked()
+{
+    if (g_ifd < 0 || ::getpid() != g_owner) return;
+
+    std::set<std::string> dirty;
+    bool rescan = false;
+
+    alignas(struct inotify_event) char buf[16 * 1024];
+    while (true) {
+        ssize_t n = ::read(g_ifd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        for (char *p = buf; p < buf + n; ) {
+            const auto *ev = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) { rescan = true; continue; }
+
+            if (ev->wd == g_root_wd) {
+                if (ev->len == 0 || !is_eid_name(ev->name)) continue;
+                if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    watch_event_dir(ev->name);
+                    dirty.insert(ev->name);
+                } else if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    forget(ev->name);
+                }
+                continue;
+            }
+
+            auto it = g_wd_eid.find(ev->wd);
+            if (it == g_wd_eid.end()) continue;
+            if (ev->mask & IN_IGNORED) { g_wd_eid.erase(it); continue; }
+            if (ev->len > 0 && is_event_file(ev->name)) dirty.insert(it->second);
+        }
+    }
+
+    if (rescan) {
+        for (auto &kv : g_wd_eid) ::inotify_rm_watch(g_ifd, kv.first);
+        g_wd_eid.clear();
+        full_scan();
+        return;
+    }
+
+    for (const auto &eid : dirty) reload(eid, g_events[eid]);
+}
+
+
+bool catalog_init()
+{
+    static bool atfork_done = false;
+    if (!atfork_done) {
+        ::pthread_atfork(atfork_prepare, atfork_release, atfork_release);
+        atfork_done = true;
+    }
+
+    CatalogGuard g;
+
+    if (g_ifd >= 0) ::close(g_ifd);   // herdado do pai (prefork)
+    g_wd_eid.clear();
+    g_events.clear();
+    g_by_owner.clear();
+    g_active = false;
+
+    g_ifd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (g_ifd < 0) return false;
+
+    ::mkdir("EVENTS", 0755);
+    g_root_wd = ::inotify_add_watch(g_ifd, "EVENTS", ROOT_MASK);
+    if (g_root_wd < 0) {
+        ::close(g_ifd);
+        g_ifd = -1;
+        return false;
+    }
+
+    g_owner  = ::getpid();
+    full_scan();
+    g_active = true;
+    return true;
+}
+
+bool catalog_active()
+{
+    return g_active;
+}
+
+void catalog_adopt()
+{
+    if (g_active && ::getpid() != g_owner) catalog_init();
+}
+
+void catalog_refresh()
+{
+    if (!g_active) return;
+    CatalogGuard g;
+    drain_locked();
+}
+
+std::uint64_t catalog_version()
+{
+    CatalogGuard g;
+    drain_locked();
+    return g_version;
+}
+
+// Entrada do EID (relida do disco com reread); nullptr se o evento não
+// existe. Um EID sem evento no disco não entra no mapa. Com g_mu.
+static CatalogEntry *lookup_locked(const std::string &eid, bool reread)
+{
+    auto it = g_events.find(eid);
+    if (it == g_events.end()) {
+        CatalogEntry e;
+        reload(eid, e);
+        if (!e.exists) return nullptr;
+        return &g_events.emplace(eid, std::move(e)).first->second;
+    }
+
+    CatalogEntry &e = it->second;
+    if (reread || !e.valid) {
+        reload(eid, e);
+    } else {
+        stats_catalog(true);
+    }
+    return e.exists ? &e : nullptr;
+}
+
+bool catalog_load_event(const std::string &eid, EventInfo &out, bool fresh)
+{
+    if (!g_active) return load_event_disk(eid, out);
+
+    CatalogGuard g;
+    if (::getpid() == g_owner) {
+        drain_locked();
+    } else if (fresh) {
+        // cópia herdada do pai: pode estar atrasada
+        const CatalogEntry *e = lookup_locked(eid, true);
+        if (!e) return false;
+        out = e->info;
+        return true;
+    }
+
+    const CatalogEntry *e = lookup_locked(eid, false);
+    if (!e) return false;
+
+    out = e->info;
+    apply_time(out);
+    return true;
+}
+
+std::vector<EventInfo> catalog_load_all()
+{
+    std::vector<EventInfo> events;
+    CatalogGuard g;
+    drain_locked();
+
+    events.reserve(g_events.size());
+    for (auto &kv : g_events) {
+        CatalogEntry &e = kv.second;
+        if (e.valid) {
+            stats_catalog(true);
+        } else {
+            reload(kv.first, e);
+        }
+        if (!e.exists) continue;
+
+        events.push_back(e.info);
+        apply_time(events.back());
+    }
+    return events;
+}
+
+std::vector<EventInfo> catalog_list(const EventFilter &f, const std::string &after,
+                                    std::size_t limit, bool &more)
+{
+    std::vector<EventInfo> out;
+    more = false;
+    CatalogGuard g;
+    drain_locked();
+
+    // true: página cheia e há mais
+    auto visit = [&](const std::string &eid, CatalogEntry &e) {
+        if (e.valid) {
+            stats_catalog(true);
+        } else {
+            reload(eid, e);
+        }
+        if (!e.exists) return false;
+
+        // passar a Past por tempo é definitivo: pode ficar guardado
+        apply_time(e.info);
+        if (!event_matches(f, e.info)) return false;
+        if (out.size() == limit) {
+            more = true;
+            return true;
+        }
+        out.push_back(e.info);
+        return false;
+    };
+
+    if (!f.owner.empty()) {
+        auto o = g_by_owner.find(f.owner);
+        if (o == g_by_owner.end()) return out;
+        for (auto it = o->second.upper_bound(after); it != o->second.end(); ++it) {
+            auto e = g_events.find(*it);
+            if (e != g_events.end() && visit(e->first, e->second)) break;
+        }
+        return out;
+    }
+
+    for (auto it = g_events.upper_bound(after); it != g_events.end(); ++it) {
+        if (visit(it->first, it->second)) break;
+    }
+    return out;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "events.h"
+
+// Catálogo de eventos em memória (EventInfo por EID).
+// Carregado no arranque e mantido em dia com inotify sobre EVENTS/ e
+// EVENTS/<eid>/ (EVENT.bin, START/RES/END): antes de cada leitura o processo
+// esvazia a fila do inotify e recarrega do disco só os eventos que
+// mudaram. Como as escritas (rename) geram o evento inotify antes de
+// retornar, quem lê depois de uma escrita vê-a sempre.
+//
+// Cada processo com catálogo tem o seu inotify (main, workers prefork).
+// Os filhos do modo fork herdam uma cópia já actualizada pelo pai antes
+// do fork() e usam-na tal como está (vivem um só comando, a não ser com
+// KAL: aí catalog_adopt); para decisões sob event_lock_path usam o
+// disco (catalog_load_event com fresh).
+//
+// Sem inotify (ou antes de catalog_init) tudo vai directamente ao disco.
+
+// Cria o inotify e carrega todos os eventos. Num processo filho de longa
+// duração (prefork) volta a criar tudo para esse processo.
+bool catalog_init();
+
+bool catalog_active();
+
+// Processo que herdou a cópia do pai e vai viver mais do que um comando
+// (ligação KAL no modo fork): passa a ter inotify e catálogo próprios.
+void catalog_adopt();
+
+// Processa as alterações pendentes (chamado também antes de fork()).
+void catalog_refresh();
+
+// Versão do catálogo: muda sempre que um evento aparece, desaparece ou
+// muda de nome, data ou estado (o que o LST mostra). Não conta as
+// passagens a Past por tempo (ver events_version).
+std::uint64_t catalog_version();
+
+// load_event/load_all_events via catálogo.
+// fresh: garante dados actuais mesmo num filho com cópia herdada.
+bool catalog_load_event(const std::string &eid, EventInfo &out, bool fresh);
+std::vector<EventInfo> catalog_load_all();
+
+// list_events via catálogo: percorre g_events (ordenado por EID) a partir
+// de after, ou o índice por dono quando o filtro tem owner.
+std::vector<EventInfo> catalog_list(const EventFilter &f, const std::string &after,
+                                    std::size_t limit, bool &more);
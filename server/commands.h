@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Registo dos comandos do protocolo: uma linha por comando, partilhado
+// pelos dispatchers UDP e TCP e pelas estatísticas por comando.
+// Para acrescentar um comando: nova entrada em CmdId e em COMMANDS e o
+// handler no dispatcher do transporte (static_assert avisa se faltar).
+//
+// A procura é um hash perfeito calculado em compilação sobre a tag de
+// 3 bytes empacotada num inteiro: uma multiplicação, um shift e uma
+// comparação.
+
+enum class CmdId : std::uint8_t {
+    LIN, LOU, UNR, LME, LMR,                 // UDP
+    LST, CRE, RID, CLS, SED, CPS, KAL, LSX,  // TCP
+    COUNT
+};
+
+constexpr std::size_t CMD_COUNT = static_cast<std::size_t>(CmdId::COUNT);
+
+enum class Transport : std::uint8_t { Udp, Tcp };
+
+struct CommandInfo {
+    char        tag[4];      // pedido
+    CmdId       id;
+    Transport   transport;
+    char        reply[4];    // tag da resposta
+    int         nargs;       // campos depois da tag (-1: variável/com dados)
+    const char *fields;      // esquema dos campos, para documentação/logs
+};
+
+constexpr CommandInfo COMMANDS[CMD_COUNT] = {
+    {"LIN", CmdId::LIN, Transport::Udp, "RLI",  2, "UID password"},
+    {"LOU", CmdId::LOU, Transport::Udp, "RLO",  2, "UID password"},
+    {"UNR", CmdId::UNR, Transport::Udp, "RUR",  2, "UID password"},
+    {"LME", CmdId::LME, Transport::Udp, "RME",  2, "UID password"},
+    {"LMR", CmdId::LMR, Transport::Udp, "RMR",  2, "UID password"},
+    {"LST", CmdId::LST, Transport::Tcp, "RLS",  0, ""},
+    {"CRE", CmdId::CRE, Transport::Tcp, "RCE", -1, "UID password name date time attendance_size Fname Fsize Fdata"},
+    {"RID", CmdId::RID, Transport::Tcp, "RRI",  4, "UID password EID people"},
+    {"CLS", CmdId::CLS, Transport::Tcp, "RCL",  3, "UID password EID"},
+    {"SED", CmdId::SED, Transport::Tcp, "RSE",  1, "EID"},
+    {"CPS", CmdId::CPS, Transport::Tcp, "RCP",  3, "UID oldPassword newPassword"},
+    {"KAL", CmdId::KAL, Transport::Tcp, "RKA",  0, ""},
+    {"LSX", CmdId::LSX, Transport::Tcp, "RLX",  7, "states from to prefix owner count after"},
+};
+
+constexpr std::size_t cmd_index(CmdId id)
+{
+    return static_cast<std::size_t>(id);
+}
+
+constexpr const CommandInfo &cmd_info(CmdId id)
+{
+    return COMMANDS[cmd_index(id)];
+}
+
+// COMMANDS[i] é o comando i
+constexpr bool cmd_table_ordered()
+{
+    for (std::size_t i = 0; i < CMD_COUNT; ++i) {
+        if (cmd_index(COMMANDS[i].id) != i) return false;
+    }
+    return true;
+}
+static_assert(cmd_table_ordered(), "COMMANDS fora da ordem de CmdId");
+
+
+// Hash perfeito
+
+constexpr std::uint32_t cmd_pack(char a, char b, char c)
+{
+    return static_cast<std::uint32_t>(static_cast<unsigned char>(a)) |
+           static_cast<std::uint32_t>(static_cast<unsigned char>(b)) << 8 |
+           static_cast<std::uint32_t>(static_cast<unsigned char>(c)) << 16;
+}
+
+constexpr unsigned CMD_HASH_BITS  = 5;
+constexpr unsigned CMD_HASH_SLOTS = 1u << CMD_HASH_BITS;
+
+constexpr unsigned cmd_hash(std::uint32_t packed, std::uint32_t mult)
+{
+    return (packed * mult) >> (32 - CMD_HASH_BITS);
+}
+
+// Primeiro multiplicador (ímpar) sem colisões entre as tags
+constexpr std::uint32_t cmd_find_mult()
+{
+    for (std::uint32_t mult = 2654435761u; ; mult += 2) {
+        bool used[CMD_HASH_SLOTS] = {};
+        bool ok = true;
+        for (const CommandInfo &c : COMMANDS) {
+            const unsigned h = cmd_hash(cmd_pack(c.tag[0], c.tag[1], c.tag[2]), mult);
+            if (used[h]) { ok = false; break; }
+            used[h] = true;
+        }
+        if (ok) return mult;
+    }
+}
+
+constexpr std::uint32_t CMD_HASH_MULT = cmd_find_mult();
+
+struct CmdSlots {
+    std::uint8_t slot[CMD_HASH_SLOTS];   // índice + 1 (0 = vazio)
+};
+
+constexpr CmdSlots cmd_build_slots()
+{
+    CmdSlots s{};
+    for (std::size_t i = 0; i < CMD_COUNT; ++i) {
+        const CommandInfo &c = COMMANDS[i];
+        s.slot[cmd_hash(cmd_pack(c.tag[0], c.tag[1], c.tag[2]), CMD_HASH_MULT)] =
+            static_cast<std::uint8_t>(i + 1);
+    }
+    return s;
+}
+
+constexpr CmdSlots CMD_SLOTS = cmd_build_slots();
+
+// Comando da tag, ou nullptr se não existir
+constexpr const CommandInfo *cmd_lookup(std::string_view tag)
+{
+    if (tag.size() != 3) return nullptr;
+    const std::uint32_t packed = cmd_pack(tag[0], tag[1], tag[2]);
+    const std::uint8_t s = CMD_SLOTS.slot[cmd_hash(packed, CMD_HASH_MULT)];
+    if (s == 0) return nullptr;
+
+    const CommandInfo &c = COMMANDS[s - 1];
+    if (cmd_pack(c.tag[0], c.tag[1], c.tag[2]) != packed) return nullptr;
+    return &c;
+}
+
+static_assert(cmd_lookup("SED") && cmd_lookup("SED")->id == CmdId::SED, "cmd_lookup");
+static_assert(!cmd_lookup("XYZ") && !cmd_lookup("SE"), "cmd_lookup");
+
+// Handlers de um transporte indexados por CmdId: todos os comandos desse
+// transporte têm handler e os outros não.
+template <typename Handler>
+constexpr bool cmd_handlers_cover(const Handler (&h)[CMD_COUNT], Transport t)
+{
+    for (std::size_t i = 0; i < CMD_COUNT; ++i) {
+        if ((COMMANDS[i].transport == t) != (h[i] != nullptr)) return false;
+    }
+    return true;
+}
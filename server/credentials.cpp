@@ -0,0 +1,176 @@
+// server/credentials.cpp
+#include "credentials.h"
+#include "protocol.h"
+#include "utils.h"      // file_exists, read_first_line
+
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+
+#include <dirent.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// 2^17 entradas x 24 bytes = 3 MB; aceita até 3/4 de ocupação
+static const std::uint32_t CRED_SLOTS     = 1u << 17;
+static const std::uint32_t CRED_MAX_USERS = CRED_SLOTS / 4 * 3;
+
+static const std::uint32_t CRED_EXISTS     = 1u << 0;
+static const std::uint32_t CRED_REGISTERED = 1u << 1;
+static const std::uint32_t CRED_LOGGED_IN  = 1u << 2;
+
+struct CredSlot {
+    std::atomic<std::uint32_t> key{0};     // uid + 1 (0 = livre)
+    std::atomic<std::uint32_t> seq{0};     // ímpar = a meio de uma escrita
+    std::atomic<std::uint32_t> flags{0};
+    std::atomic<std::uint64_t> digest{0};
+};
+
+struct CredTable {
+    std::atomic<std::uint32_t> used{0};
+    std::atomic<bool>          complete{true};   // todos os UIDs estão cá
+    std::uint64_t              salt = 0;
+    CredSlot                   slots[CRED_SLOTS];
+};
+
+static CredTable *g_table = nullptr;
+
+static std::uint32_t uid_key(const std::string &uid)
+{
+    return static_cast<std::uint32_t>(std::strtoul(uid.c_str(), nullptr, 10)) + 1;
+}
+
+static std::uint32_t slot_of(std::uint32_t key)
+{
+    return (key * 2654435761u) & (CRED_SLOTS - 1);
+}
+
+// Entrada do UID, ou nullptr. Com create, reserva uma livre.
+static CredSlot *find_slot(std::uint32_t key, bool create)
+{
+    for (std::uint32_t i = slot_of(key), n = 0; n < CRED_SLOTS;
+         i = (i + 1) & (CRED_SLOTS - 1), ++n) {
+        CredSlot &s = g_table->slots[i];
+        const std::uint32_t k = s.key.load(std::memory_order_acquire);
+        if (k == key) return &s;
+        if (k != 0) continue;
+
+        if (!create) return nullptr;
+        if (g_table->used.load() >= CRED_MAX_USERS) {
+            g_table->complete.store(false);
+            return nullptr;
+        }
+        g_table->used.fetch_add(1);
+        return &s;   // a chave só é publicada em write_slot
+    }
+    return nullptr;
+}
+
+static void write_slot(CredSlot &s, std::uint32_t key, const CredState &st)
+{
+    std::uint32_t flags = CRED_EXISTS;
+    if (st.registered) flags |= CRED_REGISTERED;
+    if (st.logged_in)  flags |= CRED_LOGGED_IN;
+
+    const std::uint32_t seq = s.seq.load(std::memory_order_relaxed);
+    s.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.flags.store(flags, std::memory_order_relaxed);
+    s.digest.store(st.digest, std::memory_order_relaxed);
+    s.seq.store(seq + 2, std::memory_order_release);
+    s.key.store(key, std::memory_order_release);
+}
+
+static void load_user(const std::string &uid)
+{
+    const std::string dir = "USERS/" + uid;
+
+    CredState st;
+    st.exists = true;
+
+    std::string pass;
+    if (read_first_line(dir + "/" + uid + "pass.txt", pass) && !pass.empty()) {
+        st.registered = true;
+        st.digest     = cred_digest(pass);
+    }
+    st.logged_in = file_exists(dir + "/" + uid + "login.txt");
+
+    cred_store(uid, st);
+}
+
+
+bool cred_init()
+{
+    void *p = ::mmap(nullptr, sizeof(CredTable), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return false;
+
+    CredTable *t = new (p) CredTable();
+    t->salt = (static_cast<std::uint64_t>(std::time(nullptr)) << 20) ^
+              static_cast<std::uint64_t>(::getpid()) ^
+              reinterpret_cast<std::uintptr_t>(p);
+
+    g_table = t;
+
+    DIR *dir = ::opendir("USERS");
+    if (!dir) return true;   // BD vazia
+
+    struct dirent *ent;
+    while ((ent = ::readdir(dir)) != nullptr) {
+        if (!proto_valid_uid(ent->d_name)) continue;
+        load_user(ent->d_name);
+    }
+    ::closedir(dir);
+    return true;
+}
+
+bool cred_lookup(const std::string &uid, CredState &out)
+{
+    if (!g_table) return false;
+
+    out = CredState{};
+    const CredSlot *s = find_slot(uid_key(uid), false);
+    if (!s) return g_table->complete.load();
+
+    std::uint32_t seq0, seq1, flags;
+    std::uint64_t digest;
+    do {
+        seq0   = s->seq.load(std::memory_order_acquire);
+        flags  = s->flags.load(std::memory_order_relaxed);
+        digest = s->digest.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq1   = s->seq.load(std::memory_order_relaxed);
+    } while ((seq0 & 1) || seq0 != seq1);
+
+    out.exists     = flags & CRED_EXISTS;
+    out.registered = flags & CRED_REGISTERED;
+    out.logged_in  = flags & CRED_LOGGED_IN;
+    out.digest     = digest;
+    return true;
+}
+
+std::uint64_t cred_digest(const std::string &password)
+{
+    // FNV-1a 64 com o sal da tabela: a password não fica em memória
+    std::uint64_t h = 14695981039346656037ull ^ (g_table ? g_table->salt : 0);
+    for (unsigned char c : password) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+bool cred_password_ok(const CredState &st, const std::string &password)
+{
+    return st.registered && st.digest == cred_digest(password);
+}
+
+void cred_store(const std::string &uid, const CredState &st)
+{
+    if (!g_table) return;
+
+    const std::uint32_t key = uid_key(uid);
+    CredSlot *s = find_slot(key, true);
+    if (s) write_slot(*s, key, st);
+}
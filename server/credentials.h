@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Tabela de credenciais residente: uid -> {digest da password, registado,
+// logged in}. Carregada de USERS/ no arranque e actualizada pelos
+// es_user_* depois de escreverem os ficheiros (que continuam a ser a
+// fonte de verdade num rearranque).
+//
+// Vive em memória partilhada (mmap anónimo antes de qualquer fork), por
+// isso os processos dos modos fork/prefork vêem todos a mesma tabela.
+// Escritas só com USERS/.lock; leituras sem lock (seqlock por entrada).
+//
+// Se a tabela encher, os UIDs que não couberam são procurados no disco.
+
+struct CredState {
+    bool          exists     = false;   // USERS/uid existe
+    bool          registered = false;   // USERS/uid/uidpass.txt existe
+    bool          logged_in  = false;   // USERS/uid/uidlogin.txt existe
+    std::uint64_t digest     = 0;       // da password (se registered)
+};
+
+// Cria a tabela e carrega USERS/. Chamar no arranque, antes de fork/threads.
+bool cred_init();
+
+// true se a tabela sabe a resposta (entrada encontrada, ou UID ausente
+// com a tabela completa); false: ir aos ficheiros.
+bool cred_lookup(const std::string &uid, CredState &out);
+
+std::uint64_t cred_digest(const std::string &password);
+
+// st.registered e a password coincide
+bool cred_password_ok(const CredState &st, const std::string &password);
+
+// Write-through depois de alterar USERS/uid. Com USERS/.lock.
+void cred_store(const std::string &uid, const CredState &st);
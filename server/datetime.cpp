@@ -0,0 +1,177 @@
+// server/datetime.cpp
+#include "datetime.h"
+
+#include <atomic>
+
+// Offset UTC por hora, mapeamento directo. Cada entrada empacota
+// (hora + DT_HOUR_BIAS) << 20 | (offset + DT_OFF_BIAS) num só atómico,
+// por isso threads diferentes podem ler e preencher sem lock.
+static const unsigned      DT_OFF_SLOTS = 256;
+static const std::int64_t  DT_HOUR_BIAS = std::int64_t(1) << 40;
+static const std::int64_t  DT_OFF_BIAS  = std::int64_t(1) << 19;
+
+static std::atomic<std::uint64_t> g_offsets[DT_OFF_SLOTS];
+
+static std::int64_t floor_div(std::int64_t a, std::int64_t b)
+{
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+// Offset (segundos a somar a UTC) da hora local no instante t
+static std::int64_t offset_at(std::int64_t t)
+{
+    const std::int64_t hour = floor_div(t, 3600);
+    const std::uint64_t key = static_cast<std::uint64_t>(hour + DT_HOUR_BIAS);
+    std::atomic<std::uint64_t> &slot = g_offsets[key % DT_OFF_SLOTS];
+
+    const std::uint64_t v = slot.load(std::memory_order_relaxed);
+    if ((v >> 20) == key) {
+        return static_cast<std::int64_t>(v & 0xFFFFF) - DT_OFF_BIAS;
+    }
+
+    const std::time_t tt = static_cast<std::time_t>(t);
+    std::tm lt{};
+    if (!::localtime_r(&tt, &lt)) return 0;
+
+    const std::int64_t off = lt.tm_gmtoff;
+    slot.store((key << 20) | static_cast<std::uint64_t>(off + DT_OFF_BIAS),
+               std::memory_order_relaxed);
+    return off;
+}
+
+// Segundos "locais" (como se o relógio local fosse UTC) -> epoch.
+// Como mktime com tm_isdst = -1: na mudança de hora fica com o
+// offset do instante resultante.
+static std::time_t local_to_epoch(std::int64_t local)
+{
+    std::int64_t off = offset_at(local);
+    std::int64_t t = local - off;
+
+    const std::int64_t off2 = offset_at(t);
+    if (off2 != off) t = local - off2;
+
+    return static_cast<std::time_t>(t);
+}
+
+// Dois/quatro dígitos em s[i..]; false se algum não for dígito
+static bool digits(const char *s, int n, int &out)
+{
+    int v = 0;
+    for (int i = 0; i < n; ++i) {
+        const unsigned d = static_cast<unsigned char>(s[i]) - '0';
+        if (d > 9) return false;
+        v = v * 10 + static_cast<int>(d);
+    }
+    out = v;
+    return true;
+}
+
+// "dd-mm-yyyy hh:mm" (+ ":ss" com seconds)
+static bool parse(const std::string &s, bool seconds, std::time_t &out)
+{
+    const std::size_t len = seconds ? DT_SECONDS_LEN : DT_EVENT_LEN;
+    if (s.size() < len) return false;
+
+    const char *p = s.data();
+    if (p[2] != '-' || p[5] != '-' || p[10] != ' ' || p[13] != ':') return false;
+    if (seconds && p[16] != ':') return false;
+
+    int day, month, year, hour, min, sec = 0;
+    if (!digits(p, 2, day) || !digits(p + 3, 2, month) || !digits(p + 6, 4, year) ||
+        !digits(p + 11, 2, hour) || !digits(p + 14, 2, min)) {
+        return false;
+    }
+    if (seconds && !digits(p + 17, 2, sec)) return false;
+
+    // mês 0 ou > 12 normalizado como no mktime
+    const int m0 = month - 1;
+    const std::int64_t y = year + floor_div(m0, 12);
+    const unsigned m = static_cast<unsigned>(m0 - floor_div(m0, 12) * 12) + 1;
+
+    const std::int64_t days = dt_days_from_civil(y, m, 1) + day - 1;
+    out = local_to_epoch(days * 86400 + hour * 3600 + min * 60 + sec);
+    return true;
+}
+
+struct Civil {
+    int year, month, day, hour, min, sec;
+};
+
+static Civil to_civil(std::time_t t)
+{
+    const std::int64_t local = static_cast<std::int64_t>(t) + offset_at(t);
+    const std::int64_t days  = floor_div(local, 86400);
+    const std::int64_t secs  = local - days * 86400;
+
+    // inverso de dt_days_from_civil
+    const std::int64_t z   = days + 719468;
+    const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp  = (5 * doy + 2) / 153;
+    const unsigned d   = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m   = mp < 10 ? mp + 3 : mp - 9;
+
+    Civil c;
+    c.year  = static_cast<int>(static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2));
+    c.month = static_cast<int>(m);
+    c.day   = static_cast<int>(d);
+    c.hour  = static_cast<int>(secs / 3600);
+    c.min   = static_cast<int>(secs / 60 % 60);
+    c.sec   = static_cast<int>(secs % 60);
+    return c;
+}
+
+static char *put(char *p, int v, int n)
+{
+    for (int i = n - 1; i >= 0; --i) {
+        p[i] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    }
+    return p + n;
+}
+
+
+bool dt_parse_event(const std::string &s, std::time_t &out)
+{
+    return parse(s, false, out);
+}
+
+bool dt_parse_seconds(const std::string &s, std::time_t &out)
+{
+    return parse(s, true, out);
+}
+
+void dt_format_seconds(std::time_t t, char *buf)
+{
+    const Civil c = to_civil(t);
+    char *p = buf;
+    p = put(p, c.day, 2);   *p++ = '-';
+    p = put(p, c.month, 2); *p++ = '-';
+    p = put(p, c.year, 4);  *p++ = ' ';
+    p = put(p, c.hour, 2);  *p++ = ':';
+    p = put(p, c.min, 2);   *p++ = ':';
+    p = put(p, c.sec, 2);
+    *p = '\0';
+}
+
+void dt_format_file(std::time_t t, char *buf)
+{
+    const Civil c = to_civil(t);
+    char *p = buf;
+    p = put(p, c.year, 4);  *p++ = '-';
+    p = put(p, c.month, 2); *p++ = '-';
+    p = put(p, c.day, 2);   *p++ = ' ';
+    p = put(p, c.hour, 2);
+    p = put(p, c.min, 2);
+    p = put(p, c.sec, 2);
+    *p = '\0';
+}
+
+std::time_t dt_now()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return ts.tv_sec;
+}
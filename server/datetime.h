@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+// Datas do protocolo ("dd-mm-yyyy hh:mm[:ss]", hora local) <-> epoch,
+// sem sscanf/mktime/strftime: os campos são lidos e escritos directamente
+// em buffers de largura fixa e a conversão de calendário é aritmética
+// (days_from_civil). O fuso vem de uma cache de offsets por hora, só
+// preenchida com localtime_r na primeira vez que cada hora aparece.
+//
+// Como mktime, campos fora do intervalo são normalizados (31-02 -> 03-03).
+
+// Dias desde 1970-01-01 (calendário gregoriano proléptico)
+constexpr std::int64_t dt_days_from_civil(std::int64_t y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+static_assert(dt_days_from_civil(1970, 1, 1) == 0, "epoch");
+static_assert(dt_days_from_civil(2000, 3, 1) == 11017, "2000-03-01");
+
+// Larguras dos formatos (sem o '\0')
+constexpr std::size_t DT_EVENT_LEN   = 16;   // dd-mm-yyyy hh:mm
+constexpr std::size_t DT_SECONDS_LEN = 19;   // dd-mm-yyyy hh:mm:ss
+constexpr std::size_t DT_FILE_LEN    = 17;   // yyyy-mm-dd hhmmss
+
+// "dd-mm-yyyy hh:mm" -> epoch
+bool dt_parse_event(const std::string &s, std::time_t &out);
+
+// "dd-mm-yyyy hh:mm:ss" -> epoch
+bool dt_parse_seconds(const std::string &s, std::time_t &out);
+
+// epoch -> "dd-mm-yyyy hh:mm:ss" (buf com DT_SECONDS_LEN + 1)
+void dt_format_seconds(std::time_t t, char *buf);
+
+// epoch -> "yyyy-mm-dd hhmmss" (nomes dos ficheiros de reserva)
+void dt_format_file(std::time_t t, char *buf);
+
+// Hora actual em segundos (CLOCK_REALTIME_COARSE: sem syscall, resolução
+// de um tick do kernel, que chega para comparações ao segundo).
+std::time_t dt_now();
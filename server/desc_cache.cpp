@@ -0,0 +1,243 @@
+// server/desc_cache.cpp
+#include "desc_cache.h"
+#include "protocol.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <pthread.h>
+#include <sys/mman.h>
+
+static const int DESC_SLOTS = 1000;   // um por EID (000..999)
+
+struct DescSlot {
+    // Muda (com g_cache->mu) antes de qualquer escrita que mova, liberte
+    // ou reescreva o bloco: quem copiou sem o lock confirma que não mudou.
+    std::atomic<std::uint64_t> seq{0};
+    bool          used = false;
+    std::uint64_t off  = 0;        // na arena
+    std::uint64_t size = 0;
+    std::uint64_t last_use = 0;    // tick do LRU
+    bool          seen = false;    // !used: fname já pedido uma vez (miss)
+    char          fname[FNAME_MAX + 1] = {};
+};
+
+// A arena (budget bytes) vem logo a seguir à estrutura. Os blocos são
+// alocados em sequência a partir de top; quando não há espaço contíguo
+// mas a soma cabe, compacta-se (só nos misses).
+struct DescCache {
+    pthread_mutex_t mu;
+    std::uint64_t   budget = 0;
+    std::uint64_t   used_bytes = 0;
+    std::uint64_t   top = 0;
+    std::uint64_t   tick = 0;
+    DescSlot        slots[DESC_SLOTS];
+};
+
+static DescCache *g_cache = nullptr;
+
+static char *arena()
+{
+    return reinterpret_cast<char *>(g_cache + 1);
+}
+
+// Antes de mexer no bloco de s (ver DescSlot::seq)
+static void bump_locked(DescSlot &s)
+{
+    s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+static void reset_locked()
+{
+    for (DescSlot &s : g_cache->slots) {
+        if (s.used) bump_locked(s);
+        s.used = s.seen = false;
+    }
+    g_cache->used_bytes = 0;
+    g_cache->top = 0;
+}
+
+static bool lock_cache()
+{
+    const int r = ::pthread_mutex_lock(&g_cache->mu);
+    if (r == EOWNERDEAD) {
+        // o dono morreu a meio: o conteúdo pode estar incoerente
+        reset_locked();
+        ::pthread_mutex_consistent(&g_cache->mu);
+        return true;
+    }
+    return r == 0;
+}
+
+static void unlock_cache()
+{
+    ::pthread_mutex_unlock(&g_cache->mu);
+}
+
+static DescSlot *slot_of(const std::string &eid)
+{
+    if (!proto_valid_eid(eid)) return nullptr;
+    return &g_cache->slots[std::atoi(eid.c_str())];
+}
+
+static void drop_locked(DescSlot &s)
+{
+    s.seen = false;
+    if (!s.used) return;
+    bump_locked(s);   // o espaço pode ser ocupado na compactação
+    s.used = false;
+    g_cache->used_bytes -= s.size;
+}
+
+static void evict_lru_locked()
+{
+    DescSlot *lru = nullptr;
+    for (DescSlot &s : g_cache->slots) {
+        if (s.used && (!lru || s.last_use < lru->last_use)) lru = &s;
+    }
+    if (lru) drop_locked(*lru);
+}
+
+// Junta os blocos vivos no início da arena (por ordem de offset)
+static void compact_locked()
+{
+    DescSlot *live[DESC_SLOTS];
+    int n = 0;
+    for (DescSlot &s : g_cache->slots) {
+        if (s.used) live[n++] = &s;
+    }
+    std::sort(live, live + n,
+              [](const DescSlot *a, const DescSlot *b) { return a->off < b->off; });
+
+    std::uint64_t top = 0;
+    for (int i = 0; i < n; ++i) {
+        if (live[i]->off != top) {
+            bump_locked(*live[i]);
+            std::memmove(arena() + top, arena() + live[i]->off, live[i]->size);
+            live[i]->off = top;
+        }
+        top += live[i]->size;
+    }
+    g_cache->top = top;
+}
+
+
+bool desc_cache_init(std::size_t mb)
+{
+    if (mb == 0) return true;
+
+    const std::size_t budget = mb << 20;
+    void *p = ::mmap(nullptr, sizeof(DescCache) + budget, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return false;
+
+    DescCache *c = new (p) DescCache();
+    c->budget = budget;
+
+    pthread_mutexattr_t attr;
+    ::pthread_mutexattr_init(&attr);
+    ::pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    ::pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    ::pthread_mutex_init(&c->mu, &attr);
+    ::pthread_mutexattr_destroy(&attr);
+
+    g_cache = c;
+    return true;
+}
+
+bool desc_cache_get(const std::string &eid, const std::string &fname,
+                    std::string &data)
+{
+    if (!g_cache) return false;
+    DescSlot *s = slot_of(eid);
+    if (!s) return false;
+
+    // só a procura é feita com o lock; a cópia é fora dele e vale se o
+    // bloco não mudou entretanto (seq). Se mudou, tenta outra vez.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!lock_cache()) return false;
+        const bool hit = s->used && fname == s->fname;
+        std::uint64_t seq = 0, off = 0, size = 0;
+        if (hit) {
+            s->last_use = ++g_cache->tick;
+            seq  = s->seq.load(std::memory_order_relaxed);
+            off  = s->off;
+            size = s->size;
+        }
+        unlock_cache();
+        if (!hit) return false;
+
+        data.assign(arena() + off, size);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s->seq.load(std::memory_order_relaxed) == seq) return true;
+    }
+    return false;
+}
+
+bool desc_cache_fits(std::size_t size)
+{
+    return g_cache && size <= g_cache->budget / 4;
+}
+
+bool desc_cache_miss(const std::string &eid, const std::string &fname,
+                     std::size_t size)
+{
+    if (!desc_cache_fits(size) || fname.size() > FNAME_MAX) return false;
+    DescSlot *s = slot_of(eid);
+    if (!s || !lock_cache()) return false;
+
+    const bool again = s->seen && fname == s->fname;
+    if (!again) {
+        drop_locked(*s);
+        s->seen = true;
+        std::memcpy(s->fname, fname.c_str(), fname.size() + 1);
+    }
+
+    unlock_cache();
+    return again;
+}
+
+void desc_cache_put(const std::string &eid, const std::string &fname,
+                    const std::string &data)
+{
+    if (!desc_cache_fits(data.size()) || fname.size() > FNAME_MAX) return;
+    DescSlot *s = slot_of(eid);
+    if (!s || !lock_cache()) return;
+
+    drop_locked(*s);
+    while (g_cache->used_bytes + data.size() > g_cache->budget) {
+        evict_lru_locked();
+    }
+    if (g_cache->top + data.size() > g_cache->budget) {
+        compact_locked();
+    }
+
+    s->off  = g_cache->top;
+    s->size = data.size();
+    s->last_use = ++g_cache->tick;
+    std::memcpy(s->fname, fname.c_str(), fname.size() + 1);
+    std::memcpy(arena() + s->off, data.data(), data.size());
+    s->used = true;
+
+    g_cache->top += data.size();
+    g_cache->used_bytes += data.size();
+
+    unlock_cache();
+}
+
+void desc_cache_invalidate(const std::string &eid)
+{
+    if (!g_cache) return;
+    DescSlot *s = slot_of(eid);
+    if (!s || !lock_cache()) return;
+
+    drop_locked(*s);
+
+    unlock_cache();
+}
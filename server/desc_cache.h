@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Cache dos ficheiros de descrição (Fdata do SED), por EID, com LRU e
+// orçamento em bytes. Vive em memória partilhada (mmap anónimo antes de
+// qualquer fork), por isso todos os processos dos modos fork/prefork
+// servem da mesma cache. Um mutex robusto process-shared protege os
+// metadados e as escritas na arena (os hits só copiam fora dele): um
+// processo morto a meio de uma operação só faz a cache ser esvaziada.
+//
+// Entradas maiores que 1/4 do orçamento não entram (ficam no sendfile).
+
+constexpr std::size_t DESC_CACHE_DEFAULT_MB = 16;
+
+// Cria a cache com mb MB (0 = desligada). Chamar antes de fork/threads.
+bool desc_cache_init(std::size_t mb);
+
+// Hit: copia o Fdata para data (um buffer só dele, que passa a segmento
+// da resposta; a compactação move os blocos, por isso a arena não serve
+// de segmento). O lock só cobre a procura: a cópia é feita fora dele e
+// confirmada pela sequência do slot. Só serve se a entrada for do mesmo
+// ficheiro (fname).
+bool desc_cache_get(const std::string &eid, const std::string &fname,
+                    std::string &data);
+
+// true se um ficheiro com size bytes pode ser guardado
+bool desc_cache_fits(std::size_t size);
+
+// Miss de um ficheiro que cabe: true se já houve um miss do mesmo fname
+// (vale a pena lê-lo para memória e fazer put); no primeiro só o regista
+// e o Fdata segue por sendfile, para não ler descrições pedidas uma vez.
+bool desc_cache_miss(const std::string &eid, const std::string &fname,
+                     std::size_t size);
+
+// Guarda (ou substitui) a descrição do evento, despejando as menos usadas.
+void desc_cache_put(const std::string &eid, const std::string &fname,
+                    const std::string &data);
+
+// Esquece a entrada do EID (CRE).
+void desc_cache_invalidate(const std::string &eid);
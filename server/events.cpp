@@ -1,18 +1,21 @@
 #include "events.h"
 
-#include "utils.h"      // file_exists, read_first_line
+#include "utils.h"      // file_exists, write_file_atomic, FsLock
+#include "io_backend.h"
+#include "catalog.h"
+#include "wal.h"
+#include "datetime.h"
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
-#include <fcntl.h>      // open(), O_CREAT, O_RDWR, etc.
-#include <unistd.h>     // close()
-#include <sys/file.h>   // flock(), LOCK_EX, LOCK_UN
-
-
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
-#include <cstdio>       // sscanf, snprintf
+#include <cstdint>
+#include <cstdio>       // snprintf
+#include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <fstream>
@@ -31,164 +34,198 @@ std::string event_dir(const std::string &eid) {
     return std::string("EVENTS/") + eid;
 }
 
-// lockfile global para BD (EVENTS/.lock)
-static const char* EVENTS_LOCK_PATH = "EVENTS/.lock";
-
-// inter-process lock (flock)
-struct EventsFsLock {
-    int fd = -1;
-
-    explicit EventsFsLock(const char* path = EVENTS_LOCK_PATH) {
-        // garantir que o diretório EVENTS existe antes de abrir lock
-        std::error_code ec;
-        if (!fs::exists("EVENTS", ec)) {
-            fs::create_directory("EVENTS", ec);
-        }
-
-        fd = ::open(path, O_CREAT | O_RDWR, 0666);
-        if (fd < 0) return;
-
-        if (::flock(fd, LOCK_EX) < 0) {
-            ::close(fd);
-            fd = -1;
-            return;
-        }
-    }
-
-    ~EventsFsLock() {
-        if (fd >= 0) {
-            ::flock(fd, LOCK_UN);
-            ::close(fd);
-        }
-    }
-
-    bool ok() const { return fd >= 0; }
-};
+// "EVENTS/<eid>/.lock"
+std::string event_lock_path(const std::string &eid) {
+    return event_dir(eid) + "/.lock";
+}
 
+// uploads CRE em curso (EVENTS/.staging)
+const char *const EVENTS_STAGING_DIR = "EVENTS/.staging";
 
-// Date parsing apenas para eventos
 
-// Parse "dd-mm-yyyy hh:mm" -> struct tm
-bool parse_event_datetime(const std::string &event_date, struct tm &out_tm) {
-    int day = 0, month = 0, year = 0, hour = 0, minute = 0;
-    if (std::sscanf(event_date.c_str(), "%2d-%2d-%4d %2d:%2d",
-                    &day, &month, &year, &hour, &minute) != 5) {
+// Primeira linha de um ficheiro já lido (como read_first_line)
+static bool first_line_of(const std::string &content, std::string &line_out) {
+    if (content.empty()) {
         return false;
     }
-
-    std::memset(&out_tm, 0, sizeof(out_tm));
-    out_tm.tm_mday = day;
-    out_tm.tm_mon  = month - 1;
-    out_tm.tm_year = year - 1900;
-    out_tm.tm_hour = hour;
-    out_tm.tm_min  = minute;
-    out_tm.tm_sec  = 0;
-
-    return true;
-}
-
-// Parse "dd-mm-yyyy hh:mm:ss" -> struct tm
-static bool parse_datetime_with_seconds(const std::string &s, struct tm &out_tm) {
-    int day = 0, month = 0, year = 0, hour = 0, minute = 0, sec = 0;
-    if (std::sscanf(s.c_str(), "%2d-%2d-%4d %2d:%2d:%2d",
-                    &day, &month, &year, &hour, &minute, &sec) != 6) {
-        return false;
-    }
-
-    std::memset(&out_tm, 0, sizeof(out_tm));
-    out_tm.tm_mday = day;
-    out_tm.tm_mon  = month - 1;
-    out_tm.tm_year = year - 1900;
-    out_tm.tm_hour = hour;
-    out_tm.tm_min  = minute;
-    out_tm.tm_sec  = sec;
-
+    line_out = content.substr(0, content.find('\n'));
     return true;
 }
 
 
 // Reserved seats
 
-// Lê o total de reservas de "RES <eid>.txt"
-static int read_total_reserved(const std::string &eid) {
-    std::string path = event_dir(eid) + "/RES " + eid + ".txt";
-
-    std::ifstream in(path);
-    if (!in.is_open()) {
-        return 0; // se não existir, consideramos 0
-    }
+// Total de reservas a partir do conteúdo de "RES <eid>.txt"
+static int parse_total_reserved(const std::string &content) {
+    std::istringstream in(content);
 
     int value = 0;
     in >> value;
     if (!in.good()) {
-        return 0;
+        return 0; // se não existir ou mal formado, consideramos 0
     }
     return value;
 }
 
 
-static EventState compute_state(const std::string &eid,
-                                const std::string &event_date_str,
-                                int capacity,
-                                int reserved,
-                                bool has_end_file,
-                                bool &closed_by_user_out)
+// Estado a partir das datas já em epoch
+static EventState compute_state(const EventInfo &info, bool &closed_by_user_out)
 {
     closed_by_user_out = false;
 
-    struct tm event_tm{};
-    if (!parse_event_datetime(event_date_str, event_tm)) {
+    // se existe END, distinguimos "Past" de "ClosedByUser":
+    // END == data do evento: terminou automaticamente por "Past";
+    // END != data do evento, mal formado ou ilegível: fechado pelo dono.
+    if (info.has_end_file) {
+        if (info.end_ts != 0 && info.end_ts == info.event_ts) {
+            return EventState::Past;
+        }
+        closed_by_user_out = true;
+        return EventState::ClosedByUser;
+    }
+
+    // sem END: o agendador (expiry.h) escreve-o no segundo a seguir à
+    // hora do evento. Só nessa janela é o relógio que dá Past.
+    if (dt_now() > info.event_ts) {
         return EventState::Past;
     }
 
-    const time_t event_ts = std::mktime(&event_tm);
+    if (info.capacity > 0 && info.reserved >= info.capacity) {
+        return EventState::SoldOut;
+    }
 
-    // se existe END, distinguimos "Past" de "ClosedByUser"
-    if (has_end_file) {
-        const std::string end_path = event_dir(eid) + "/END " + eid + ".txt";
-        std::string line;
+    return EventState::Open;
+}
 
-        if (read_first_line(end_path, line)) {
-            struct tm end_tm{};
-            if (parse_datetime_with_seconds(line, end_tm)) {
-                const time_t end_ts = std::mktime(&end_tm);
 
-                // se END != data do evento é fechado pelo dono;
-                // se END == data do evento então terminou automaticamente por "Past".
-                if (end_ts != event_ts) {
-                    closed_by_user_out = true;
-                    return EventState::ClosedByUser;
-                }
-                return EventState::Past;
-            }
+void event_compute_state(EventInfo &info, const std::string *end_line)
+{
+    info.end_ts = 0;
+    std::time_t end_ts = 0;
+    if (info.has_end_file && end_line && dt_parse_seconds(*end_line, end_ts)) {
+        info.end_ts = end_ts;
+    }
 
-            // se END mal formado consideramos fechado pelo dono
-            closed_by_user_out = true;
-            return EventState::ClosedByUser;
-        }
+    bool closed_by_user = false;
+    info.state = compute_state(info, closed_by_user);
+    info.closed_by_user = closed_by_user;
+}
 
-        // se não conseguiu ler END consideramos fechado pelo dono
-        closed_by_user_out = true;
-        return EventState::ClosedByUser;
-    }
 
-    // sem END decide por tempo e por lotação
-    const time_t now_ts = std::time(nullptr);
+// Registo binário (EVENT.bin)
 
-    if (now_ts > event_ts) {
-        return EventState::Past;
-    }
+static const char EVENT_RECORD_MAGIC[4] = {'E', 'S', 'E', 'V'};
+static const std::uint32_t EVENT_RECORD_VERSION = 1;
 
-    if (capacity > 0 && reserved >= capacity) {
-        return EventState::SoldOut;
+static const std::uint8_t EVREC_HAS_END = 1u << 0;
+
+// campos de texto com '\0' no fim
+struct EventRecord {
+    char          magic[4];
+    std::uint32_t version;
+    std::int64_t  event_ts;
+    std::int64_t  end_ts;
+    std::int32_t  capacity;
+    std::int32_t  reserved;
+    std::uint8_t  flags;
+    char          owner_uid[7];
+    char          name[11];
+    char          desc_fname[25];
+    char          event_date[17];     // "dd-mm-yyyy hh:mm"
+    char          pad[3];
+};
+static_assert(sizeof(EventRecord) == 96, "EventRecord tem de ter largura fixa");
+
+static void copy_field(char *dst, std::size_t cap, const std::string &src)
+{
+    std::memset(dst, 0, cap);
+    std::memcpy(dst, src.data(), std::min(src.size(), cap - 1));
+}
+
+static std::string field_str(const char *src, std::size_t cap)
+{
+    return std::string(src, ::strnlen(src, cap));
+}
+
+std::string event_record_path(const std::string &eid) {
+    return event_dir(eid) + "/EVENT.bin";
+}
+
+std::string event_record_encode(const EventInfo &info)
+{
+    EventRecord rec{};
+    std::memcpy(rec.magic, EVENT_RECORD_MAGIC, sizeof(rec.magic));
+    rec.version  = EVENT_RECORD_VERSION;
+    rec.event_ts = static_cast<std::int64_t>(info.event_ts);
+    rec.end_ts   = static_cast<std::int64_t>(info.end_ts);
+    rec.capacity = info.capacity;
+    rec.reserved = info.reserved;
+    rec.flags    = info.has_end_file ? EVREC_HAS_END : 0;
+    copy_field(rec.owner_uid,  sizeof(rec.owner_uid),  info.owner_uid);
+    copy_field(rec.name,       sizeof(rec.name),       info.name);
+    copy_field(rec.desc_fname, sizeof(rec.desc_fname), info.desc_fname);
+    copy_field(rec.event_date, sizeof(rec.event_date), info.event_date);
+
+    return std::string(reinterpret_cast<const char*>(&rec), sizeof(rec));
+}
+
+static bool event_record_decode(const std::string &eid, const std::string &data,
+                                EventInfo &out)
+{
+    EventRecord rec;
+    if (data.size() != sizeof(rec)) return false;
+    std::memcpy(&rec, data.data(), sizeof(rec));
+    if (std::memcmp(rec.magic, EVENT_RECORD_MAGIC, sizeof(rec.magic)) != 0 ||
+        rec.version != EVENT_RECORD_VERSION) {
+        return false;
     }
 
-    return EventState::Open;
+    EventInfo info;
+    info.eid          = eid;
+    info.owner_uid    = field_str(rec.owner_uid,  sizeof(rec.owner_uid));
+    info.name         = field_str(rec.name,       sizeof(rec.name));
+    info.desc_fname   = field_str(rec.desc_fname, sizeof(rec.desc_fname));
+    info.event_date   = field_str(rec.event_date, sizeof(rec.event_date));
+    info.event_ts     = static_cast<std::time_t>(rec.event_ts);
+    info.end_ts       = static_cast<std::time_t>(rec.end_ts);
+    info.capacity     = rec.capacity;
+    info.reserved     = rec.reserved;
+    info.has_end_file = rec.flags & EVREC_HAS_END;
+
+    bool closed_by_user = false;
+    info.state = compute_state(info, closed_by_user);
+    info.closed_by_user = closed_by_user;
+
+    out = std::move(info);
+    return true;
+}
+
+
+// Com event_lock_path(eid) na mão: escreve END (texto e, se existir, o
+// registo binário). end_datetime "dd-mm-yyyy hh:mm:ss" = end_ts.
+static bool event_write_end_locked(const std::string &eid,
+                                   const std::string &end_datetime,
+                                   std::time_t end_ts)
+{
+    const std::string end_path = event_dir(eid) + "/END " + eid + ".txt";
+    if (!write_file_atomic(end_path, end_datetime + "\n")) return false;
+
+    // registo binário, se o evento já o tiver (senão vale o texto)
+    std::string data;
+    EventInfo info;
+    if (!io_read_file(event_record_path(eid), data) ||
+        !event_record_decode(eid, data, info)) {
+        return true;
+    }
+    info.has_end_file = true;
+    info.end_ts       = end_ts;
+    return write_file_atomic(event_record_path(eid), event_record_encode(info));
 }
 
 
 bool ensure_end_if_past(const std::string &eid, const std::string &event_date_str)
 {
+    if (wal_enabled()) return wal_ensure_end_if_past(eid);
 
     const std::string end_path = event_dir(eid) + "/END " + eid + ".txt";
 
@@ -196,40 +233,72 @@ bool ensure_end_if_past(const std::string &eid, const std::string &event_date_st
         return true; // já existe
     }
 
+    FsLock lock(event_lock_path(eid).c_str());
+    if (!lock.ok()) {
+        return false;
+    }
+    if (file_exists(end_path)) {
+        return true; // criado entretanto (CLS ou outro pedido)
+    }
+
     // event_date_str: "dd-mm-yyyy hh:mm"
-    int day=0, month=0, year=0, hour=0, min=0;
-    if (std::sscanf(event_date_str.c_str(), "%2d-%2d-%4d %2d:%2d",
-                    &day, &month, &year, &hour, &min) != 5) {
+    std::time_t end_ts = 0;
+    if (!dt_parse_event(event_date_str, end_ts)) {
         return false;
     }
 
-    std::tm tm_end{};
-    tm_end.tm_mday = day;
-    tm_end.tm_mon  = month - 1;
-    tm_end.tm_year = year - 1900;
-    tm_end.tm_hour = hour;
-    tm_end.tm_min  = min;
-    tm_end.tm_sec  = 0;
+    char buf[DT_SECONDS_LEN + 1];
+    dt_format_seconds(end_ts, buf);
 
-    char buf[32];
-    if (std::strftime(buf, sizeof(buf), "%d-%m-%Y %H:%M:%S", &tm_end) == 0) {
-        return false;
+    return event_write_end_locked(eid, buf, end_ts);
+}
+
+bool es_close_event(const std::string &eid)
+{
+    if (wal_enabled()) return wal_close_event(eid);
+
+    const std::string end_path = event_dir(eid) + "/END " + eid + ".txt";
+
+    FsLock lock(event_lock_path(eid).c_str());
+    if (!lock.ok() || file_exists(end_path)) {
+        return false; // evento inexistente, ou já fechado/terminado entretanto
     }
 
-    std::ofstream out(end_path);
-    if (!out.is_open()) return false;
+    const std::time_t now = dt_now();
+
+    char buf[DT_SECONDS_LEN + 1];
+    dt_format_seconds(now, buf);
 
-    out << buf << "\n";
-    return out.good();
+    return event_write_end_locked(eid, buf, now);
 }
 
 
 bool load_event(const std::string &eid, EventInfo &out) {
+    if (wal_enabled()) return wal_load_event(eid, out);
+    return catalog_load_event(eid, out, false);
+}
+
+bool load_event_fresh(const std::string &eid, EventInfo &out) {
+    if (wal_enabled()) return wal_load_event(eid, out);
+    return catalog_load_event(eid, out, true);
+}
+
+// START/RES/END (eventos ainda sem EVENT.bin)
+static bool load_event_text(const std::string &eid, EventInfo &out) {
     const std::string base = event_dir(eid);
-    const std::string start_path = base + "/START " + eid + ".txt";
+
+    // START, RES e END lidos de uma vez
+    const std::string paths[3] = {
+        base + "/START " + eid + ".txt",
+        base + "/RES " + eid + ".txt",
+        base + "/END " + eid + ".txt"
+    };
+    std::string data[3];
+    bool found[3] = {false, false, false};
+    io_read_files(paths, data, found, 3);
 
     std::string line;
-    if (!read_first_line(start_path, line) || line.empty()) {
+    if (!found[0] || !first_line_of(data[0], line) || line.empty()) {
         return false;
     }
 
@@ -251,30 +320,83 @@ bool load_event(const std::string &eid, EventInfo &out) {
     info.capacity   = capacity;
     info.event_date = date_part + " " + time_part;
 
-    struct tm tmp{};
-    if (!parse_event_datetime(info.event_date, tmp)) {
+    if (!dt_parse_event(info.event_date, info.event_ts)) {
         return false;
     }
 
-    info.reserved = read_total_reserved(eid);
+    info.reserved = found[1] ? parse_total_reserved(data[1]) : 0;
+    info.has_end_file = found[2];
 
-    const std::string end_path = base + "/END " + eid + ".txt";
-    info.has_end_file = file_exists(end_path);
+    std::string end_line;
+    const bool end_ok = found[2] && first_line_of(data[2], end_line);
 
-    bool closed_by_user = false;
-    info.state = compute_state(eid,
-                               info.event_date,
-                               info.capacity,
-                               info.reserved,
-                               info.has_end_file,
-                               closed_by_user);
-    info.closed_by_user = closed_by_user;
+    event_compute_state(info, end_ok ? &end_line : nullptr);
 
     out = std::move(info);
     return true;
 }
 
+bool load_event_disk(const std::string &eid, EventInfo &out) {
+    std::string data;
+    if (io_read_file(event_record_path(eid), data) &&
+        event_record_decode(eid, data, out)) {
+        return true;
+    }
+    return load_event_text(eid, out);
+}
+
+bool events_version(std::uint64_t &out) {
+    if (wal_enabled()) {
+        out = wal_events_version();
+        return true;
+    }
+    if (catalog_active()) {
+        out = catalog_version();
+        return true;
+    }
+    return false;
+}
+
+bool event_matches(const EventFilter &f, const EventInfo &ev)
+{
+    return (f.states & (1u << static_cast<int>(ev.state))) != 0 &&
+           ev.event_ts >= f.from && ev.event_ts <= f.to &&
+           ev.name.compare(0, f.prefix.size(), f.prefix) == 0 &&
+           (f.owner.empty() || ev.owner_uid == f.owner);
+}
+
+std::vector<EventInfo> list_events(const EventFilter &f, const std::string &after,
+                                   std::size_t limit, bool &more)
+{
+    if (wal_enabled()) {
+        return wal_list_events(f, after, limit, more);
+    }
+    if (catalog_active()) {
+        return catalog_list(f, after, limit, more);
+    }
+
+    // sem índices: a lista toda, filtrada
+    std::vector<EventInfo> out;
+    more = false;
+    for (auto &ev : load_all_events()) {
+        if (ev.eid <= after || !event_matches(f, ev)) continue;
+        if (out.size() == limit) {
+            more = true;
+            break;
+        }
+        out.push_back(std::move(ev));
+    }
+    return out;
+}
+
 std::vector<EventInfo> load_all_events() {
+    if (wal_enabled()) {
+        return wal_load_all_events();
+    }
+    if (catalog_active()) {
+        return catalog_load_all();
+    }
+
     std::vector<EventInfo> events;
 
     DIR *dir = ::opendir("EVENTS");
@@ -297,7 +419,7 @@ std::vector<EventInfo> load_all_events() {
 
     for (const auto &eid : eids) {
         EventInfo info;
-        if (load_event(eid, info)) {
+        if (load_event_disk(eid, info)) {
             events.push_back(std::move(info));
         }
     }
@@ -315,31 +437,94 @@ static void ensure_events_root()
     }
 }
 
-// Cria o diretório do evento e devolve EID + base.
-// tentar mkdir(EVENTS/001), mkdir(EVENTS/002), ...
+int es_open_staging_file(std::string &path_out)
+{
+    ensure_events_root();
+
+    std::error_code ec;
+    fs::create_directory(EVENTS_STAGING_DIR, ec);
+
+    static std::atomic<unsigned> seq{0};
+    path_out = std::string(EVENTS_STAGING_DIR) + "/" + std::to_string(::getpid()) +
+               "." + std::to_string(seq.fetch_add(1));
+
+    return ::open(path_out.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+}
+
+// Mapa de EIDs atribuídos: bit i = EVENTS/<i> existe (1..999).
+// EVENTS/.eidmap guarda-o em disco e o flock sobre ele serializa os CRE.
+// As directorias continuam a ser a verdade: uma entrada em falta (crash
+// entre o mkdir e a escrita do mapa, ou árvore de uma versão anterior)
+// corrige-se sozinha quando o mkdir devolver EEXIST.
+static const char *const EID_MAP_PATH = "EVENTS/.eidmap";
+static const int EID_MAP_WORDS = 16;   // 1024 bits
+
+// Mapa a partir das directorias (mapa novo ou com tamanho errado)
+static void build_eid_map(std::uint64_t map[EID_MAP_WORDS])
+{
+    std::memset(map, 0, EID_MAP_WORDS * sizeof(std::uint64_t));
+    map[0] = 1;   // EID 000 não existe
+
+    DIR *dir = ::opendir("EVENTS");
+    if (!dir) return;
+
+    struct dirent *ent;
+    while ((ent = ::readdir(dir)) != nullptr) {
+        if (ent->d_name[0] == '.' || std::strlen(ent->d_name) != 3) continue;
+        const int i = std::atoi(ent->d_name);
+        if (i >= 1 && i <= 999) map[i / 64] |= std::uint64_t(1) << (i % 64);
+    }
+    ::closedir(dir);
+}
+
+// Cria o diretório do evento e devolve EID + base: com o flock do
+// .eidmap, o primeiro bit livre do mapa (ctz por palavra, sem percorrer
+// EVENTS/) e mkdir(EVENTS/<eid>). Se o mkdir der EEXIST o bit fica
+// marcado e passa ao livre seguinte; no fim o mapa volta ao disco.
 static bool allocate_and_create_event_dir(std::string &eid_out, std::string &base_out)
 {
     ensure_events_root();
 
-    for (int i = 1; i <= 999; ++i) {
-        char buf[4];
-        std::snprintf(buf, sizeof(buf), "%03d", i);
+    FsLock lock(EID_MAP_PATH);
+    if (!lock.ok()) {
+        return false;
+    }
+
+    std::uint64_t map[EID_MAP_WORDS];
+    if (::pread(lock.fd, map, sizeof(map), 0) != static_cast<ssize_t>(sizeof(map))) {
+        build_eid_map(map);
+    }
 
-        std::string eid(buf);
-        std::string base = event_dir(eid);
+    bool found = false;
+    for (int w = 0; w < EID_MAP_WORDS && !found; ) {
+        if (map[w] == ~std::uint64_t(0)) {
+            ++w;
+            continue;
+        }
+        const int i = w * 64 + __builtin_ctzll(~map[w]);
+        if (i > 999) break;
+        map[w] |= std::uint64_t(1) << (i % 64);
 
-        std::error_code ec;
-        bool created = fs::create_directory(base, ec);
-        if (created && !ec) {
-            eid_out = std::move(eid);
-            base_out = std::move(base);
-            return true;
+        char buf[4];
+        std::snprintf(buf, sizeof(buf), "%03d", i);
+        const std::string base = event_dir(buf);
+
+        if (::mkdir(base.c_str(), 0755) == 0) {
+            eid_out  = buf;
+            base_out = base;
+            found = true;
+        } else if (errno != EEXIST) {
+            map[w] &= ~(std::uint64_t(1) << (i % 64));
+            break;
         }
+        // EEXIST: já ocupado, o bit fica marcado e tenta o seguinte
+    }
 
-        // Se já existe, tenta o próximo.
-        // Para qualquer outro erro, continuamos a tentar,
+    // mesmo sem EID livre guarda o que se aprendeu com os EEXIST
+    if (::pwrite(lock.fd, map, sizeof(map), 0) != static_cast<ssize_t>(sizeof(map))) {
+        (void)::ftruncate(lock.fd, 0);   // mapa parcial: reconstruído no próximo CRE
     }
-    return false;
+    return found;
 }
 
 bool es_create_event(const std::string &uid,
@@ -348,9 +533,14 @@ bool es_create_event(const std::string &uid,
                      const std::string &time_part,
                      int attendance,
                      const std::string &fname,
-                     const std::string &file_data,
+                     const std::string &staged_path,
                      std::string &eid_out)
 {
+    if (wal_enabled()) {
+        return wal_create_event(uid, name, date_part, time_part, attendance,
+                                fname, staged_path, eid_out);
+    }
+
     // em USERS/<uid>/CREATED etc
 
     std::error_code ec;
@@ -361,30 +551,10 @@ bool es_create_event(const std::string &uid,
     }
     const std::string eid = eid_out;
 
-    // START
-    {
-        const std::string start_path = base + "/START " + eid + ".txt";
-        std::ofstream out(start_path);
-        if (!out.is_open()) return false;
-
-        out << uid << " "
-            << name << " "
-            << fname << " "
-            << attendance << " "
-            << date_part << " "
-            << time_part << "\n";
-
-        if (!out.good()) return false;
-    }
-
     // RES
     {
         const std::string res_path = base + "/RES " + eid + ".txt";
-        std::ofstream out(res_path);
-        if (!out.is_open()) return false;
-
-        out << 0 << "\n";
-        if (!out.good()) return false;
+        if (!write_file_atomic(res_path, "0\n")) return false;
     }
 
     // DESCRIPTION/Fname
@@ -393,13 +563,9 @@ bool es_create_event(const std::string &uid,
         fs::create_directory(desc_dir, ec);
         if (ec) return false;
 
+        // Fdata já está em disco: basta mudar o ficheiro de sítio
         const std::string fpath = desc_dir + "/" + fname;
-        std::ofstream out(fpath, std::ios::binary);
-        if (!out.is_open()) return false;
-
-        out.write(file_data.data(),
-                  static_cast<std::streamsize>(file_data.size()));
-        if (!out.good()) return false;
+        if (::rename(staged_path.c_str(), fpath.c_str()) != 0) return false;
     }
 
     // RESERVATIONS/
@@ -421,5 +587,74 @@ bool es_create_event(const std::string &uid,
         if (!out.good()) return false;
     }
 
+    // START por último: só a partir daqui o evento fica visível (load_event)
+    {
+        const std::string start_path = base + "/START " + eid + ".txt";
+        std::ostringstream out;
+        out << uid << " "
+            << name << " "
+            << fname << " "
+            << attendance << " "
+            << date_part << " "
+            << time_part << "\n";
+
+        if (!write_file_atomic(start_path, out.str())) return false;
+    }
+
+    // EVENT.bin: daqui em diante lido em vez de START/RES/END
+    {
+        EventInfo info;
+        info.eid        = eid;
+        info.owner_uid  = uid;
+        info.name       = name;
+        info.desc_fname = fname;
+        info.capacity   = attendance;
+        info.event_date = date_part + " " + time_part;
+
+        if (!dt_parse_event(info.event_date, info.event_ts)) return false;
+
+        if (!write_file_atomic(event_record_path(eid), event_record_encode(info))) return false;
+    }
+
     return true;
 }
+
+int es_convert_events()
+{
+    DIR *dir = ::opendir("EVENTS");
+    if (!dir) return 0;
+
+    std::vector<std::string> eids;
+    struct dirent *ent;
+    while ((ent = ::readdir(dir)) != nullptr) {
+        if (ent->d_name[0] == '.') continue;
+        if (std::strlen(ent->d_name) != 3) continue;
+        eids.emplace_back(ent->d_name);
+    }
+    ::closedir(dir);
+
+    std::sort(eids.begin(), eids.end());
+
+    int converted = 0;
+    for (const auto &eid : eids) {
+        // o texto é a referência (refaz EVENT.bin mesmo que já exista),
+        // menos nas reservas: essas só o EVENT.bin tem em dia, e o RES
+        // é reescrito a partir dele
+        FsLock lock(event_lock_path(eid).c_str());
+        EventInfo info;
+        if (!lock.ok() || !load_event_text(eid, info)) continue;
+
+        std::string data;
+        EventInfo bin;
+        if (io_read_file(event_record_path(eid), data) &&
+            event_record_decode(eid, data, bin) && bin.reserved != info.reserved) {
+            info.reserved = bin.reserved;
+            write_file_atomic(event_dir(eid) + "/RES " + eid + ".txt",
+                              std::to_string(info.reserved) + "\n");
+        }
+        if (write_file_atomic(event_record_path(eid), event_record_encode(info))) {
+            ++converted;
+        }
+    }
+    return converted;
+}
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <ctime>
+#include <limits>
 
 // Estados de evento:
 // 0 – evento no passado
@@ -22,35 +24,103 @@ struct EventInfo {
     std::string name;        // nome curto
     std::string desc_fname;  // nome do ficheiro de descrição
     std::string event_date;  // "dd-mm-yyyy hh:mm"
+    std::time_t event_ts = 0;  // event_date em hora local
     int         capacity = 0;
     int         reserved = 0;
     EventState  state   = EventState::Past;
 
     bool        has_end_file   = false;
+    std::time_t end_ts         = 0;   // END em epoch (0: sem END ou ilegível)
     bool        closed_by_user = false;
 };
 
+
+// Diretório dos uploads CRE ainda sem EID.
+extern const char *const EVENTS_STAGING_DIR;
+
 // Caminho "EVENTS/<eid>"
 std::string event_dir(const std::string &eid);
 
-// Lê 1 evento a partir de EVENTS/eid (START/RES/END, etc.)
+// Lockfile do evento, "EVENTS/<eid>/.lock" (flock): serializa as escritas
+// nesse evento (RID, CLS, END automático) entre processos e threads.
+// Eventos diferentes não se bloqueiam uns aos outros.
+// Se o evento não existir, FsLock fica !ok() (não cria a diretoria).
+std::string event_lock_path(const std::string &eid);
+
+// Lê 1 evento (catálogo em memória, ou EVENTS/eid se inactivo)
 bool load_event(const std::string &eid, EventInfo &out);
 
+// Como load_event, mas sempre com os dados actuais em disco: usar para
+// decisões tomadas sob event_lock_path(eid) (RID).
+bool load_event_fresh(const std::string &eid, EventInfo &out);
+
+// Lê 1 evento directamente de EVENTS/eid: o registo binário EVENT.bin
+// (um só read, datas já em epoch) ou, se ainda não existir, START/RES/END.
+bool load_event_disk(const std::string &eid, EventInfo &out);
+
+// Registo binário do evento, "EVENTS/<eid>/EVENT.bin": largura fixa, com
+// lotação, reservas, dono, nome, ficheiro e datas (texto e epoch).
+// START/RES/END continuam a ser escritos, como formato de exportação;
+// as reservas só contam no EVENT.bin (o RES é derivado dele).
+std::string event_record_path(const std::string &eid);
+std::string event_record_encode(const EventInfo &info);
+
+// Converte uma árvore EVENTS/ antiga: cria EVENT.bin a partir de
+// START/RES/END em todos os eventos (as reservas de um EVENT.bin que já
+// exista mantêm-se e o RES é acertado). Devolve quantos converteu.
+int es_convert_events();
+
 // Lê todos os eventos em EVENTS/, ordenados por EID
 std::vector<EventInfo> load_all_events();
 
-// Parse "dd-mm-yyyy hh:mm" - struct tm
-bool parse_event_datetime(const std::string &event_date, struct tm &out_tm);
+// Versão da lista de eventos (catálogo ou WAL): igual entre duas chamadas
+// => load_all_events devolve o mesmo, a menos de eventos que passaram a
+// Past entretanto (isso depende só da hora: ver event_ts). false se o
+// backend não tiver versão (ficheiros sem catálogo).
+bool events_version(std::uint64_t &out);
+
+// Filtro do LSX (listagem paginada). Por omissão aceita tudo.
+struct EventFilter {
+    unsigned    states = 0xF;   // bit s: aceita EventState s
+    std::time_t from   = std::numeric_limits<std::time_t>::min();   // event_ts >= from
+    std::time_t to     = std::numeric_limits<std::time_t>::max();   // event_ts <= to
+    std::string prefix;         // início do nome (vazio: qualquer)
+    std::string owner;          // UID do dono (vazio: qualquer)
+};
+
+bool event_matches(const EventFilter &f, const EventInfo &ev);
+
+// Uma página do LSX: até limit eventos com EID > after que passam o
+// filtro, por ordem de EID. more = há mais depois do último devolvido.
+std::vector<EventInfo> list_events(const EventFilter &f, const std::string &after,
+                                   std::size_t limit, bool &more);
+
+// Calcula end_ts, state e closed_by_user a partir de event_ts, capacity,
+// reserved e has_end_file (end_line: primeira linha de END, se houver).
+void event_compute_state(EventInfo &info, const std::string *end_line);
+
+// Abre um ficheiro novo em EVENTS_STAGING_DIR para receber o Fdata de
+// um CRE antes de haver EID. Devolve o fd (escrita) ou -1.
+int es_open_staging_file(std::string &path_out);
 
 // Criação de evento 
+// staged_path: Fdata já escrito (es_open_staging_file); é movido com
+// rename para EVENTS/<eid>/DESCRIPTION/<fname>. Se falhar, o ficheiro
+// pode ficar em staged_path e cabe a quem chama apagá-lo.
 bool es_create_event(const std::string &uid,
                      const std::string &name,
                      const std::string &date_part,
                      const std::string &time_part,
                      int attendance,
                      const std::string &fname,
-                     const std::string &file_data,
+                     const std::string &staged_path,
                      std::string &eid_out);
 
+// END automático (data/hora do próprio evento) de um evento passado.
+// Chamado pelo agendador de expiração (expiry.h).
 bool ensure_end_if_past(const std::string &eid, const std::string &event_date_str);
 
+// CLS: escreve END com a data/hora actual.
+// Devolve false se já existir END ou em caso de erro.
+bool es_close_event(const std::string &eid);
+
@@ -0,0 +1,143 @@
+// server/expiry.cpp
+#include "expiry.h"
+#include "events.h"
+#include "datetime.h"
+
+#include <cerrno>
+#include <ctime>
+#include <functional>
+#include <queue>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+using Deadline = std::pair<std::time_t, std::string>;   // (hora do evento, EID)
+
+// Canal de expiry_schedule: criado antes de qualquer fork, por isso os
+// filhos (fork/prefork) escrevem no mesmo pipe que a thread lê.
+// Cada registo é "EID\n", bem abaixo de PIPE_BUF: escritas atómicas.
+static int   g_chan[2] = {-1, -1};   // [0]: thread, [1]: expiry_schedule
+static pid_t g_owner   = 0;
+
+// Só a thread mexe no heap
+static std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> g_heap;
+static std::set<std::string> g_scheduled;   // EIDs no heap
+
+// A thread escreve END com flock na mão: um fork() nesse momento deixava
+// o filho com o fd do lock e o evento bloqueado até o filho sair.
+static pthread_mutex_t g_work_mu = PTHREAD_MUTEX_INITIALIZER;
+
+static void atfork_prepare() { ::pthread_mutex_lock(&g_work_mu); }
+static void atfork_release() { ::pthread_mutex_unlock(&g_work_mu); }
+
+static void push(const EventInfo &ev)
+{
+    if (ev.has_end_file || g_scheduled.count(ev.eid)) return;
+    g_heap.emplace(ev.event_ts, ev.eid);
+    g_scheduled.insert(ev.eid);
+}
+
+// Esvazia o canal e agenda os EIDs que lá estavam
+static void read_channel()
+{
+    static std::string carry;   // registo a meio (não acontece com escritas atómicas)
+
+    char buf[4096];
+    while (true) {
+        ssize_t n = ::read(g_chan[0], buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        for (ssize_t i = 0; i < n; ++i) {
+            if (buf[i] != '\n') {
+                carry.push_back(buf[i]);
+                continue;
+            }
+            EventInfo ev;
+            if (load_event(carry, ev)) push(ev);
+            carry.clear();
+        }
+    }
+}
+
+// Devolve false se o evento ainda não passou (relógio mudou): fica no heap.
+static bool expire(const std::string &eid)
+{
+    ::pthread_mutex_lock(&g_work_mu);
+
+    bool done = true;
+    EventInfo ev;
+    if (load_event_fresh(eid, ev) && !ev.has_end_file) {
+        if (ev.state == EventState::Past) {
+            ensure_end_if_past(eid, ev.event_date);
+        } else {
+            done = false;
+        }
+    }
+
+    ::pthread_mutex_unlock(&g_work_mu);
+    return done;
+}
+
+static void expiry_loop()
+{
+    // eventos de antes do arranque; daí em diante só o canal
+    for (const auto &ev : load_all_events()) push(ev);
+
+    while (true) {
+        read_channel();
+
+        // Past é "agora > hora do evento"
+        while (!g_heap.empty() && g_heap.top().first < dt_now()) {
+            Deadline d = g_heap.top();
+            g_heap.pop();
+
+            if (expire(d.second)) {
+                g_scheduled.erase(d.second);
+            } else {
+                g_heap.push(std::move(d));
+                break;
+            }
+        }
+
+        // acorda com o canal ou no segundo a seguir ao próximo evento
+        std::time_t wait = EXPIRY_MAX_SLEEP_SEC;
+        if (!g_heap.empty()) {
+            const std::time_t due = g_heap.top().first + 1 - dt_now();
+            if (due < wait) wait = due;
+        }
+        if (wait < 1) wait = 1;   // evento que ainda não passou
+
+        struct pollfd pfd{g_chan[0], POLLIN, 0};
+        ::poll(&pfd, 1, static_cast<int>(wait) * 1000);
+    }
+}
+
+
+void expiry_start()
+{
+    if (g_owner != 0) return;
+    if (::pipe2(g_chan, O_NONBLOCK | O_CLOEXEC) != 0) return;
+    g_owner = ::getpid();
+
+    ::pthread_atfork(atfork_prepare, atfork_release, atfork_release);
+    std::thread(expiry_loop).detach();
+}
+
+void expiry_schedule(const std::string &eid)
+{
+    if (g_chan[1] < 0) return;
+
+    const std::string rec = eid + "\n";
+    ssize_t n;
+    do {
+        n = ::write(g_chan[1], rec.data(), rec.size());
+    } while (n < 0 && errno == EINTR);
+    // pipe cheio (milhares de EIDs por ler): o evento fica pelo relógio
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+// Expiração de eventos: uma thread do processo principal com um min-heap
+// (hora do evento, EID) escreve o END automático de cada evento logo que
+// ele passa (ensure_end_if_past), fora do caminho dos pedidos.
+//
+// No arranque agenda os eventos que já existem; daí em diante só os que
+// chegam por expiry_schedule, de qualquer processo (pipe partilhado com
+// os filhos fork/prefork), sem voltar a ler EVENTS/. compute_state só
+// dá Past pela hora no segundo entre a hora do evento e o END escrito.
+
+// Sem eventos para breve, a thread revê o heap pelo menos com este
+// intervalo (acertos do relógio).
+constexpr int EXPIRY_MAX_SLEEP_SEC = 60;
+
+// Arranca a thread (uma vez, no processo principal, depois do catálogo/WAL).
+void expiry_start();
+
+// Evento novo: agendar já. Pode ser chamado em qualquer processo
+// depois de expiry_start (os filhos herdam o canal).
+void expiry_schedule(const std::string &eid);
@@ -0,0 +1,651 @@
+// server/io_backend.cpp
+#include "io_backend.h"
+#include "utils.h"
+
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+
+#ifdef ES_IO_URING
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+static bool g_uring_enabled = false;
+
+
+// Caminho bloqueante
+
+static bool read_file_blocking(const std::string &path, std::string &out)
+{
+    out.clear();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        out.reserve(static_cast<std::size_t>(st.st_size));
+    }
+
+    char buf[16 * 1024];
+    while (true) {
+        ssize_t r = ::read(fd, buf, sizeof(buf));
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            return false;
+        }
+        if (r == 0) break;
+        out.append(buf, static_cast<std::size_t>(r));
+    }
+    ::close(fd);
+    return true;
+}
+
+// Salta os primeiros done bytes de iov[0..n): devolve o nº de iovecs
+// que sobram (iov passa a começar no primeiro com bytes por enviar).
+static std::size_t iov_advance(struct iovec *&iov, std::size_t n, std::size_t done)
+{
+    while (n > 0 && done >= iov->iov_len) {
+        done -= iov->iov_len;
+        ++iov;
+        --n;
+    }
+    if (n > 0) {
+        iov->iov_base = static_cast<char*>(iov->iov_base) + done;
+        iov->iov_len -= done;
+    }
+    return n;
+}
+
+static bool sendmsg_all_blocking(int fd, struct iovec *iov, std::size_t n, int flags)
+{
+    n = iov_advance(iov, n, 0);
+    while (n > 0) {
+        struct msghdr msg{};
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = n;
+        ssize_t r = ::sendmsg(fd, &msg, flags | MSG_NOSIGNAL);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        n = iov_advance(iov, n, static_cast<std::size_t>(r));
+    }
+    return true;
+}
+
+
+#ifdef ES_IO_URING
+
+// io_uring sem liburing: syscalls directas + rings mapeados
+
+struct Ring {
+    int   fd    = -1;
+    pid_t owner = 0;    // depois de fork() o ring não pode ser partilhado
+
+    unsigned *sq_head  = nullptr;
+    unsigned *sq_tail  = nullptr;
+    unsigned *sq_mask  = nullptr;
+    unsigned *sq_array = nullptr;
+    unsigned  sq_entries = 0;
+    io_uring_sqe *sqes = nullptr;
+
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    void       *sq_ring = nullptr;
+    std::size_t sq_ring_sz = 0;
+    void       *cq_ring = nullptr;
+    std::size_t cq_ring_sz = 0;
+    std::size_t sqes_sz = 0;
+
+    unsigned to_submit = 0;
+};
+
+static const unsigned RING_ENTRIES = 64;
+
+static void ring_teardown(Ring &r)
+{
+    if (r.sqes) ::munmap(r.sqes, r.sqes_sz);
+    if (r.cq_ring && r.cq_ring != r.sq_ring) ::munmap(r.cq_ring, r.cq_ring_sz);
+    if (r.sq_ring) ::munmap(r.sq_ring, r.sq_ring_sz);
+    if (r.fd >= 0) ::close(r.fd);
+    r = Ring{};
+}
+
+static bool ring_probe_ops(int ring_fd)
+{
+    const unsigned nops = 256;
+    std::vector<char> mem(sizeof(io_uring_probe) + nops * sizeof(io_uring_probe_op), 0);
+    auto *probe = reinterpret_cast<io_uring_probe*>(mem.data());
+
+    if (::syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE,
+                  probe, nops) < 0) {
+        return false;
+    }
+
+    const int needed[] = {IORING_OP_OPENAT, IORING_OP_STATX,
+                          IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE,
+                          IORING_OP_RENAMEAT, IORING_OP_SENDMSG, IORING_OP_RECV,
+                          IORING_OP_LINK_TIMEOUT};
+    for (int op : needed) {
+        if (op > probe->last_op) return false;
+        if (!(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+    }
+    return true;
+}
+
+static bool ring_setup(Ring &r)
+{
+    io_uring_params p{};
+    int fd = static_cast<int>(::syscall(__NR_io_uring_setup, RING_ENTRIES, &p));
+    if (fd < 0) return false;
+    r.fd    = fd;
+    r.owner = ::getpid();
+
+    r.sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r.cq_ring_sz = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        if (r.cq_ring_sz > r.sq_ring_sz) r.sq_ring_sz = r.cq_ring_sz;
+        r.cq_ring_sz = r.sq_ring_sz;
+    }
+
+    r.sq_ring = ::mmap(nullptr, r.sq_ring_sz, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (r.sq_ring == MAP_FAILED) { r.sq_ring = nullptr; ring_teardown(r); return false; }
+
+    if (single) {
+        r.cq_ring = r.sq_ring;
+    } else {
+        r.cq_ring = ::mmap(nullptr, r.cq_ring_sz, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (r.cq_ring == MAP_FAILED) { r.cq_ring = nullptr; ring_teardown(r); return false; }
+    }
+
+    r.sqes_sz = p.sq_entries * sizeof(io_uring_sqe);
+    void *sq = ::mmap(nullptr, r.sqes_sz, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sq == MAP_FAILED) { ring_teardown(r); return false; }
+    r.sqes = static_cast<io_uring_sqe*>(sq);
+
+    char *sqb = static_cast<char*>(r.sq_ring);
+    r.sq_head    = reinterpret_cast<unsigned*>(sqb + p.sq_off.head);
+    r.sq_tail    = reinterpret_cast<unsigned*>(sqb + p.sq_off.tail);
+    r.sq_mask    = reinterpret_cast<unsigned*>(sqb + p.sq_off.ring_mask);
+    r.sq_array   = reinterpret_cast<unsigned*>(sqb + p.sq_off.array);
+    r.sq_entries = p.sq_entries;
+
+    char *cqb = static_cast<char*>(r.cq_ring);
+    r.cq_head = reinterpret_cast<unsigned*>(cqb + p.cq_off.head);
+    r.cq_tail = reinterpret_cast<unsigned*>(cqb + p.cq_off.tail);
+    r.cq_mask = reinterpret_cast<unsigned*>(cqb + p.cq_off.ring_mask);
+    r.cqes    = reinterpret_cast<io_uring_cqe*>(cqb + p.cq_off.cqes);
+
+    if (!ring_probe_ops(fd)) { ring_teardown(r); return false; }
+    return true;
+}
+
+// Ring da thread actual (criado à primeira utilização; recriado no filho
+// depois de fork). nullptr => usar o caminho bloqueante.
+static Ring *ring_get()
+{
+    if (!g_uring_enabled) return nullptr;
+
+    thread_local Ring ring;
+    if (ring.fd >= 0 && ring.owner == ::getpid()) return &ring;
+    if (ring.fd >= 0) ring_teardown(ring);   // herdado do pai
+    if (!ring_setup(ring)) return nullptr;
+    return &ring;
+}
+
+// SQEs livres no SQ
+static unsigned ring_space(const Ring &r)
+{
+    const unsigned head = __atomic_load_n(r.sq_head, __ATOMIC_ACQUIRE);
+    return r.sq_entries - (*r.sq_tail - head);
+}
+
+// Submete o que está no SQ sem esperar pelos CQEs (ring_run recolhe-os
+// depois, contam para o n de quem os pôs). false se não avançou.
+static bool ring_flush(Ring &r)
+{
+    if (r.to_submit == 0) return false;
+
+    int ret;
+    do {
+        ret = static_cast<int>(::syscall(__NR_io_uring_enter, r.fd, r.to_submit,
+                                         0, 0, nullptr, 0));
+    } while (ret < 0 && errno == EINTR);
+    if (ret <= 0) return false;
+
+    r.to_submit -= static_cast<unsigned>(ret) < r.to_submit
+                   ? static_cast<unsigned>(ret) : r.to_submit;
+    return true;
+}
+
+// Garante k SQEs livres: uma cadeia ligada tem de ir toda na mesma
+// submissão, por isso reserva-se antes da primeira SQE da cadeia.
+static bool ring_reserve(Ring &r, unsigned k)
+{
+    if (k > r.sq_entries) return false;
+    while (ring_space(r) < k) {
+        if (!ring_flush(r)) return false;
+    }
+    return true;
+}
+
+// Próxima SQE; com o SQ cheio submete primeiro o que lá está.
+// nullptr se nem assim houver lugar.
+static io_uring_sqe *ring_sqe(Ring &r, std::uint8_t opcode, int fd, std::uint64_t user_data)
+{
+    if (!ring_reserve(r, 1)) return nullptr;
+
+    const unsigned tail = *r.sq_tail;
+    const unsigned idx = tail & *r.sq_mask;
+    io_uring_sqe *sqe = &r.sqes[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = opcode;
+    sqe->fd        = fd;
+    sqe->user_data = user_data;
+
+    r.sq_array[idx] = idx;
+    __atomic_store_n(r.sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++r.to_submit;
+    return sqe;
+}
+
+// Submete tudo e espera por n CQEs; res[user_data] = resultado.
+static bool ring_run(Ring &r, unsigned n, int *res, std::size_t nres)
+{
+    unsigned done = 0;
+    while (done < n) {
+        int ret = static_cast<int>(::syscall(__NR_io_uring_enter, r.fd, r.to_submit,
+                                             1, IORING_ENTER_GETEVENTS, nullptr, 0));
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        r.to_submit -= static_cast<unsigned>(ret) < r.to_submit
+                       ? static_cast<unsigned>(ret) : r.to_submit;
+
+        unsigned head = *r.cq_head;
+        const unsigned tail = __atomic_load_n(r.cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            const io_uring_cqe &cqe = r.cqes[head & *r.cq_mask];
+            if (cqe.user_data < nres) res[cqe.user_data] = cqe.res;
+            ++head;
+            ++done;
+        }
+        __atomic_store_n(r.cq_head, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+// Um lote de ficheiros vai em poucas submissões, cada uma com todos os
+// ficheiros do lote (nada de open/fstat bloqueantes entre elas):
+//   leitura: OPENAT; STATX do fd aberto; READ -(hardlink)-> CLOSE
+//   escrita: OPENAT(tmp); WRITE -(link)-> RENAMEAT -(hardlink)-> CLOSE
+// O fd do OPENAT e o tamanho do STATX só se conhecem no CQE, por isso
+// não dá para ligar tudo numa só cadeia (seriam precisos ficheiros
+// registados). Até 3 SQEs por ficheiro numa submissão.
+static const std::size_t URING_FILES_PER_SUBMIT = RING_ENTRIES / 3;
+
+// OPENAT de cnt caminhos numa submissão; fds[k] = fd ou -1.
+// false se o ring falhar (os fds que abriram ficam perdidos).
+static bool uring_open_all(Ring &r, const std::string *paths, std::size_t cnt,
+                           int flags, int *fds)
+{
+    int res[URING_FILES_PER_SUBMIT];
+    unsigned nsqe = 0;
+
+    for (std::size_t k = 0; k < cnt; ++k) {
+        fds[k] = -1;
+        res[k] = -ECANCELED;
+        io_uring_sqe *op = ring_sqe(r, IORING_OP_OPENAT, AT_FDCWD, k);
+        if (!op) continue;
+        op->addr       = reinterpret_cast<std::uint64_t>(paths[k].c_str());
+        op->open_flags = static_cast<std::uint32_t>(flags | O_CLOEXEC);
+        op->len        = 0666;
+        ++nsqe;
+    }
+
+    if (nsqe > 0 && !ring_run(r, nsqe, res, cnt)) return false;
+    for (std::size_t k = 0; k < cnt; ++k) fds[k] = res[k] >= 0 ? res[k] : -1;
+    return true;
+}
+
+static void close_all(int *fds, std::size_t cnt)
+{
+    for (std::size_t k = 0; k < cnt; ++k) {
+        if (fds[k] >= 0) ::close(fds[k]);
+        fds[k] = -1;
+    }
+}
+
+static void uring_read_files(Ring &r, const std::string *paths, std::string *out,
+                             bool *ok, std::size_t n)
+{
+    for (std::size_t base = 0; base < n; base += URING_FILES_PER_SUBMIT) {
+        const std::size_t cnt = std::min(URING_FILES_PER_SUBMIT, n - base);
+        int fds[URING_FILES_PER_SUBMIT];
+        struct statx stx[URING_FILES_PER_SUBMIT];
+        int res[2 * URING_FILES_PER_SUBMIT];
+        unsigned nsqe = 0;
+
+        for (std::size_t k = 0; k < cnt; ++k) {
+            ok[base + k] = false;
+            out[base + k].clear();
+        }
+
+        bool ring_ok = uring_open_all(r, paths + base, cnt, O_RDONLY, fds);
+
+        // tamanho do ficheiro que foi aberto (não do caminho, que um
+        // rename pode entretanto ter trocado)
+        for (std::size_t k = 0; ring_ok && k < cnt; ++k) {
+            res[k] = -ECANCELED;
+            if (fds[k] < 0) continue;
+            io_uring_sqe *st = ring_sqe(r, IORING_OP_STATX, fds[k], k);
+            if (!st) continue;
+            st->addr        = reinterpret_cast<std::uint64_t>("");
+            st->len         = STATX_SIZE;
+            st->statx_flags = AT_EMPTY_PATH;
+            st->addr2       = reinterpret_cast<std::uint64_t>(&stx[k]);
+            ++nsqe;
+        }
+        if (ring_ok && nsqe > 0) ring_ok = ring_run(r, nsqe, res, cnt);
+
+        nsqe = 0;
+        for (std::size_t k = 0; ring_ok && k < cnt; ++k) {
+            if (fds[k] < 0) continue;
+            if (res[k] < 0 || !ring_reserve(r, 2)) {
+                ::close(fds[k]);
+                fds[k] = -1;
+                continue;
+            }
+            out[base + k].resize(static_cast<std::size_t>(stx[k].stx_size));
+
+            io_uring_sqe *rd = ring_sqe(r, IORING_OP_READ, fds[k], 2 * k);
+            rd->addr  = reinterpret_cast<std::uint64_t>(out[base + k].data());
+            rd->len   = static_cast<std::uint32_t>(out[base + k].size());
+            rd->off   = 0;
+            rd->flags = IOSQE_IO_HARDLINK;   // fecha mesmo que a leitura falhe
+            ring_sqe(r, IORING_OP_CLOSE, fds[k], 2 * k + 1);
+            nsqe += 2;
+        }
+        for (std::size_t k = 0; k < 2 * cnt; ++k) res[k] = -ECANCELED;
+        if (ring_ok && nsqe > 0) ring_ok = ring_run(r, nsqe, res, 2 * cnt);
+
+        if (!ring_ok) {
+            // não devia acontecer: repetir pelo caminho bloqueante
+            if (nsqe == 0) close_all(fds, cnt);
+            for (std::size_t k = 0; k < cnt; ++k) {
+                ok[base + k] = read_file_blocking(paths[base + k], out[base + k]);
+            }
+            continue;
+        }
+
+        for (std::size_t k = 0; k < cnt; ++k) {
+            if (fds[k] < 0) continue;
+            if (res[2 * k + 1] == -ECANCELED) ::close(fds[k]);
+            if (res[2 * k] < 0) { out[base + k].clear(); continue; }
+            out[base + k].resize(static_cast<std::size_t>(res[2 * k]));
+            ok[base + k] = true;
+        }
+    }
+}
+
+static bool uring_write_files_atomic(Ring &r, const std::string *paths,
+                                     const std::string *contents, std::size_t n)
+{
+    static std::atomic<unsigned> seq{0};
+    bool all_ok = true;
+
+    for (std::size_t base = 0; base < n; base += URING_FILES_PER_SUBMIT) {
+        const std::size_t cnt = std::min(URING_FILES_PER_SUBMIT, n - base);
+        int fds[URING_FILES_PER_SUBMIT];
+        std::string tmps[URING_FILES_PER_SUBMIT];
+        int res[3 * URING_FILES_PER_SUBMIT];
+
+        for (std::size_t k = 0; k < cnt; ++k) {
+            tmps[k] = paths[base + k] + ".tmp" + std::to_string(::getpid()) +
+                      "." + std::to_string(seq.fetch_add(1));
+        }
+
+        if (!uring_open_all(r, tmps, cnt, O_WRONLY | O_CREAT | O_TRUNC, fds)) {
+            for (std::size_t k = 0; k < cnt; ++k) {
+                ::unlink(tmps[k].c_str());
+                if (!write_file_atomic(paths[base + k], contents[base + k])) all_ok = false;
+            }
+            continue;
+        }
+
+        unsigned nsqe = 0;
+        for (std::size_t k = 0; k < cnt; ++k) {
+            const std::size_t i = base + k;
+            res[3 * k] = res[3 * k + 1] = res[3 * k + 2] = -ECANCELED;
+            if (fds[k] >= 0 && !ring_reserve(r, 3)) {
+                ::close(fds[k]);
+                ::unlink(tmps[k].c_str());
+                fds[k] = -1;
+            }
+            if (fds[k] < 0) { all_ok = false; continue; }
+
+            io_uring_sqe *wr = ring_sqe(r, IORING_OP_WRITE, fds[k], 3 * k);
+            wr->addr  = reinterpret_cast<std::uint64_t>(contents[i].data());
+            wr->len   = static_cast<std::uint32_t>(contents[i].size());
+            wr->off   = 0;
+            wr->flags = IOSQE_IO_LINK;
+
+            io_uring_sqe *rn = ring_sqe(r, IORING_OP_RENAMEAT, AT_FDCWD, 3 * k + 1);
+            rn->addr  = reinterpret_cast<std::uint64_t>(tmps[k].c_str());
+            rn->len   = static_cast<std::uint32_t>(AT_FDCWD);
+            rn->addr2 = reinterpret_cast<std::uint64_t>(paths[i].c_str());
+            rn->flags = IOSQE_IO_HARDLINK;
+
+            ring_sqe(r, IORING_OP_CLOSE, fds[k], 3 * k + 2);
+            nsqe += 3;
+        }
+
+        if (nsqe > 0 && !ring_run(r, nsqe, res, 3 * cnt)) {
+            for (std::size_t k = 0; k < cnt; ++k) {
+                if (fds[k] < 0) continue;
+                ::close(fds[k]);
+                ::unlink(tmps[k].c_str());
+                if (!write_file_atomic(paths[base + k], contents[base + k])) all_ok = false;
+            }
+            continue;
+        }
+
+        for (std::size_t k = 0; k < cnt; ++k) {
+            if (fds[k] < 0) continue;
+            if (res[3 * k + 2] == -ECANCELED) ::close(fds[k]);
+
+            const bool wrote   = res[3 * k] == static_cast<int>(contents[base + k].size());
+            const bool renamed = res[3 * k + 1] == 0;
+            if (!wrote || !renamed) {
+                if (!renamed) ::unlink(tmps[k].c_str());
+                all_ok = false;
+            }
+        }
+    }
+    return all_ok;
+}
+
+static bool uring_single(Ring &r, std::uint8_t op, int fd, void *buf,
+                         std::size_t n, int &result)
+{
+    io_uring_sqe *sqe = ring_sqe(r, op, fd, 0);
+    if (!sqe) return false;
+    sqe->addr      = reinterpret_cast<std::uint64_t>(buf);
+    sqe->len       = static_cast<std::uint32_t>(n);
+    result = -ECANCELED;
+    return ring_run(r, 1, &result, 1);
+}
+
+// RECV -(link)-> LINK_TIMEOUT: se o tempo acabar primeiro o RECV é
+// cancelado (-ECANCELED), que passa a EAGAIN como no SO_RCVTIMEO.
+static bool uring_recv_timeout(Ring &r, int fd, void *buf, std::size_t n,
+                               int timeout_ms, int &result)
+{
+    struct __kernel_timespec ts{};
+    ts.tv_sec  = timeout_ms / 1000;
+    ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+
+    // o RECV ligado não pode ir sem o timeout: os dois ou nenhum
+    if (!ring_reserve(r, 2)) return false;
+
+    io_uring_sqe *sqe = ring_sqe(r, IORING_OP_RECV, fd, 0);
+    sqe->addr  = reinterpret_cast<std::uint64_t>(buf);
+    sqe->len   = static_cast<std::uint32_t>(n);
+    sqe->flags = IOSQE_IO_LINK;
+
+    io_uring_sqe *to = ring_sqe(r, IORING_OP_LINK_TIMEOUT, -1, 1);
+    to->addr = reinterpret_cast<std::uint64_t>(&ts);
+    to->len  = 1;
+
+    int res[2] = {-ECANCELED, -ECANCELED};
+    if (!ring_run(r, 2, res, 2)) return false;
+    result = res[0] == -ECANCELED ? -EAGAIN : res[0];
+    return true;
+}
+
+static bool uring_sendmsg(Ring &r, int fd, struct msghdr *msg, int flags, int &result)
+{
+    io_uring_sqe *sqe = ring_sqe(r, IORING_OP_SENDMSG, fd, 0);
+    if (!sqe) return false;
+    sqe->addr      = reinterpret_cast<std::uint64_t>(msg);
+    sqe->len       = 1;
+    sqe->msg_flags = static_cast<std::uint32_t>(flags | MSG_NOSIGNAL);
+    result = -ECANCELED;
+    return ring_run(r, 1, &result, 1);
+}
+
+#endif // ES_IO_URING
+
+
+bool io_backend_init(bool want_uring)
+{
+    g_uring_enabled = false;
+    if (!want_uring) return false;
+
+#ifdef ES_IO_URING
+    g_uring_enabled = true;
+    if (ring_get() == nullptr) {
+        g_uring_enabled = false;
+        std::cerr << "[ES] io_uring unavailable, using blocking I/O\n";
+        return false;
+    }
+    return true;
+#else
+    std::cerr << "[ES] built without io_uring (make IO_URING=1), using blocking I/O\n";
+    return false;
+#endif
+}
+
+bool io_backend_uring_enabled()
+{
+    return g_uring_enabled;
+}
+
+void io_read_files(const std::string *paths, std::string *out, bool *ok,
+                   std::size_t n)
+{
+#ifdef ES_IO_URING
+    if (Ring *r = ring_get()) {
+        uring_read_files(*r, paths, out, ok, n);
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < n; ++i) {
+        ok[i] = read_file_blocking(paths[i], out[i]);
+    }
+}
+
+bool io_read_file(const std::string &path, std::string &out)
+{
+    bool ok = false;
+    io_read_files(&path, &out, &ok, 1);
+    return ok;
+}
+
+bool io_write_files_atomic(const std::string *paths, const std::string *contents,
+                           std::size_t n)
+{
+#ifdef ES_IO_URING
+    if (Ring *r = ring_get()) {
+        return uring_write_files_atomic(*r, paths, contents, n);
+    }
+#endif
+    bool all_ok = true;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!write_file_atomic(paths[i], contents[i])) all_ok = false;
+    }
+    return all_ok;
+}
+
+bool io_write_file_atomic(const std::string &path, const std::string &content)
+{
+    return io_write_files_atomic(&path, &content, 1);
+}
+
+ssize_t io_recv(int fd, void *buf, std::size_t n, int timeout_ms)
+{
+#ifdef ES_IO_URING
+    if (Ring *r = ring_get()) {
+        int res = 0;
+        const bool done = timeout_ms >= 0
+            ? uring_recv_timeout(*r, fd, buf, n, timeout_ms, res)
+            : uring_single(*r, IORING_OP_RECV, fd, buf, n, res);
+        if (done) {
+            if (res < 0) { errno = -res; return -1; }
+            return res;
+        }
+    }
+#endif
+    if (timeout_ms >= 0) {
+        struct pollfd pfd{fd, POLLIN, 0};
+        int ready;
+        do {
+            ready = ::poll(&pfd, 1, timeout_ms);
+        } while (ready < 0 && errno == EINTR);
+        if (ready == 0) { errno = EAGAIN; return -1; }
+        if (ready < 0) return -1;
+    }
+    return ::read(fd, buf, n);
+}
+
+bool io_sendmsg_all(int fd, struct iovec *iov, std::size_t n, int flags)
+{
+#ifdef ES_IO_URING
+    if (Ring *r = ring_get()) {
+        n = iov_advance(iov, n, 0);
+        while (n > 0) {
+            struct msghdr msg{};
+            msg.msg_iov    = iov;
+            msg.msg_iovlen = n;
+            int res = 0;
+            if (!uring_sendmsg(*r, fd, &msg, flags, res)) {
+                return sendmsg_all_blocking(fd, iov, n, flags);
+            }
+            if (res <= 0) return false;
+            n = iov_advance(iov, n, static_cast<std::size_t>(res));
+        }
+        return true;
+    }
+#endif
+    return sendmsg_all_blocking(fd, iov, n, flags);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// Backend de I/O do servidor.
+//  - bloqueante: read()/write()/open() directos (por omissão)
+//  - io_uring:   compilado com `make IO_URING=1` e activado com --io-uring;
+//                open/statx também vão pelo ring e cada passo (OPENAT,
+//                STATX, READ->CLOSE / WRITE->RENAME->CLOSE) leva os
+//                ficheiros todos de um pedido numa só submissão.
+// Se o io_uring não estiver disponível (kernel, seccomp, build sem
+// suporte), tudo cai no caminho bloqueante.
+
+// Tenta activar o io_uring. Devolve false (e fica bloqueante) se não der.
+bool io_backend_init(bool want_uring);
+
+bool io_backend_uring_enabled();
+
+// Lê n ficheiros inteiros (pequenos ou grandes). ok[i] = false se o
+// ficheiro não existir ou der erro; out[i] fica com o conteúdo.
+void io_read_files(const std::string *paths, std::string *out, bool *ok,
+                   std::size_t n);
+
+// Lê um ficheiro inteiro. Devolve false se não existir ou der erro.
+bool io_read_file(const std::string &path, std::string &out);
+
+// Escreve n ficheiros de forma atómica (temporário + rename).
+// Devolve true só se todos foram escritos.
+bool io_write_files_atomic(const std::string *paths, const std::string *contents,
+                           std::size_t n);
+
+// Escreve um ficheiro de forma atómica (temporário + rename).
+bool io_write_file_atomic(const std::string &path, const std::string &content);
+
+// Socket: recv de até n bytes (devolve como read()).
+// timeout_ms >= 0: sem dados nesse tempo devolve -1 com errno EAGAIN, como
+// SO_RCVTIMEO (que o IORING_OP_RECV ignora; aqui vale nos dois backends).
+ssize_t io_recv(int fd, void *buf, std::size_t n, int timeout_ms = -1);
+
+// Socket: envia todos os bytes de iov[0..n) (um sendmsg, mais se o envio
+// ficar a meio; iov é alterado). flags extra para o sendmsg (MSG_MORE).
+bool io_sendmsg_all(int fd, struct iovec *iov, std::size_t n, int flags);
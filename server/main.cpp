@@ -3,7 +3,10 @@
 #include <csignal>
 #include <cerrno>
 #include <cstring>
+#include <thread>
+#include <vector>
 
+#include <pthread.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -17,6 +20,16 @@
 #include "udp_handler.h"
 #include "tcp.h"
 #include "udp.h"
+#include "reactor.h"
+#include "workers.h"
+#include "stats.h"
+#include "io_backend.h"
+#include "catalog.h"
+#include "wal.h"
+#include "reservations.h"
+#include "credentials.h"
+#include "expiry.h"
+#include "desc_cache.h"
 
 // sockets globais para os handlers de sinal
 static int  g_udp_sock = -1;
@@ -25,20 +38,61 @@ static bool g_verbose  = false;
 
 //Signals
 
-static void sigint_handler(int)
+// SIGINT/SIGTERM/SIGUSR1 ficam bloqueados em todas as threads e são
+// recebidos por sigwait numa thread própria: stats_dump (iostream, locks)
+// não é async-signal-safe e não pode correr num signal handler.
+static sigset_t g_wait_set;
+
+static void block_signals()
 {
-    std::cout << "\n[ES] SIGINT received: closing sockets.\n";
+    ::sigemptyset(&g_wait_set);
+    ::sigaddset(&g_wait_set, SIGINT);
+    ::sigaddset(&g_wait_set, SIGTERM);
+    ::sigaddset(&g_wait_set, SIGUSR1);
+    ::pthread_sigmask(SIG_BLOCK, &g_wait_set, nullptr);
+}
 
-    if (g_udp_sock != -1) {
-        ::close(g_udp_sock);
-        g_udp_sock = -1;
-    }
-    if (g_tcp_sock != -1) {
-        ::close(g_tcp_sock);
-        g_tcp_sock = -1;
-    }
+// filhos (fork/prefork): SIGINT/SIGTERM voltam a terminar o processo
+static void unblock_in_child()
+{
+    sigset_t set;
+    ::sigemptyset(&set);
+    ::sigaddset(&set, SIGINT);
+    ::sigaddset(&set, SIGTERM);
+    ::pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+}
+
+static void signal_loop()
+{
+    while (true) {
+        int sig = 0;
+        if (::sigwait(&g_wait_set, &sig) != 0) continue;
+
+        if (sig == SIGUSR1) {
+            // kill -USR1 <pid> imprime os contadores
+            stats_dump(std::cout);
+            std::cout.flush();
+            continue;
+        }
 
-    std::_Exit(0);
+        std::cout << "\n[ES] " << (sig == SIGTERM ? "SIGTERM" : "SIGINT")
+                  << " received: closing sockets.\n";
+        stats_dump(std::cout);
+        std::cout.flush();
+
+        prefork_shutdown();
+
+        if (g_udp_sock != -1) {
+            ::close(g_udp_sock);
+            g_udp_sock = -1;
+        }
+        if (g_tcp_sock != -1) {
+            ::close(g_tcp_sock);
+            g_tcp_sock = -1;
+        }
+
+        std::_Exit(0);
+    }
 }
 
 static void sigchld_handler(int)
@@ -49,17 +103,21 @@ static void sigchld_handler(int)
 
 static void setup_signals()
 {
-    struct sigaction sa{};
-    sa.sa_handler = sigint_handler;
-    ::sigemptyset(&sa.sa_mask);
-    sa.sa_flags = 0;
-    ::sigaction(SIGINT, &sa, nullptr);
+    ::pthread_atfork(nullptr, nullptr, unblock_in_child);
+    std::thread(signal_loop).detach();
 
     struct sigaction sa2{};
     sa2.sa_handler = sigchld_handler;
     ::sigemptyset(&sa2.sa_mask);
     sa2.sa_flags = SA_RESTART;
     ::sigaction(SIGCHLD, &sa2, nullptr);
+
+    // escrita para um cliente que já fechou: tratamos o EPIPE
+    // em vez de matar o processo (essencial nos modos sem fork)
+    struct sigaction sa3{};
+    sa3.sa_handler = SIG_IGN;
+    ::sigemptyset(&sa3.sa_mask);
+    ::sigaction(SIGPIPE, &sa3, nullptr);
 }
 
 
@@ -69,10 +127,50 @@ int main(int argc, char **argv)
     parse_server_args(cfg, argc, argv);
     g_verbose = cfg.verbose;
 
+    if (cfg.convert_events) {
+        // conversor de árvores EVENTS/ antigas para EVENT.bin
+        int n = es_convert_events();
+        std::cout << "[ES] Converted " << n << " events to EVENT.bin\n";
+        return 0;
+    }
+
+    // antes de qualquer thread (expiry, catálogo, shards): todas herdam a máscara
+    block_signals();
+
+    stats_init();
+    udp_set_batch_size(cfg.udp_batch);
+    io_backend_init(cfg.io_uring);
+    if (!desc_cache_init(cfg.desc_cache_mb)) {
+        std::cerr << "[ES] Cannot map description cache, SED reads from disk\n";
+    }
+    if (cfg.storage == StorageBackend::Wal) {
+        // com o log, o índice em memória já faz o papel do catálogo
+        if (!wal_open(WAL_DIR)) {
+            std::cerr << "[ES] Cannot open WAL storage in " << WAL_DIR << "/\n";
+            return 1;
+        }
+    } else {
+        if (!cred_init()) {
+            std::cerr << "[ES] Cannot map credential table, using USERS/ files\n";
+        }
+        int migrated = es_reservations_backfill_index();
+        if (migrated > 0) {
+            std::cout << "[ES] Reservation index built for " << migrated << " users\n";
+        }
+        if (!catalog_init()) {
+            std::cerr << "[ES] inotify unavailable, event catalog disabled\n";
+        }
+    }
+    expiry_start();
     setup_signals();
 
     // cria sockets
-    g_udp_sock = udp_create_socket(cfg.port);
+    // com vários shards UDP, cada socket (SO_REUSEPORT) tem a sua thread
+    // e o loop principal deixa de tratar UDP (udp_fd = -1)
+    const bool sharded = cfg.udp_shards > 1;
+    std::vector<int> udp_shards;
+
+    g_udp_sock = udp_create_socket(cfg.port, sharded);
     g_tcp_sock = tcp_create_listen_socket(cfg.port);
 
     if (g_udp_sock < 0 || g_tcp_sock < 0) {
@@ -80,18 +178,68 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    if (sharded) {
+        udp_shards.push_back(g_udp_sock);
+        for (std::size_t i = 1; i < cfg.udp_shards; ++i) {
+            int fd = udp_create_socket(cfg.port, true);
+            if (fd < 0) {
+                std::cerr << "Error creating UDP shard " << i << ".\n";
+                return 1;
+            }
+            udp_shards.push_back(fd);
+        }
+        udp_shards_start(udp_shards, g_verbose);
+    }
+    const int loop_udp = sharded ? -1 : g_udp_sock;
+
     std::cout << "[ES] Listening on TCP/UDP port " << cfg.port << "\n";
     if (g_verbose) {
         std::cout << "[ES] Verbose ON\n";
     }
+    if (sharded) {
+        std::cout << "[ES] UDP: " << udp_shards.size() << " SO_REUSEPORT shards\n";
+    }
+    if (cfg.udp_batch > 1) {
+        std::cout << "[ES] UDP: batches of up to " << cfg.udp_batch << " datagrams\n";
+    }
+    if (wal_enabled()) {
+        std::cout << "[ES] Storage: write-ahead log (" << WAL_DIR << "/)\n";
+    }
+    if (io_backend_uring_enabled()) {
+        std::cout << "[ES] I/O: io_uring\n";
+    }
+
+    if (cfg.concurrency != ConcurrencyModel::Fork) {
+        switch (cfg.concurrency) {
+        case ConcurrencyModel::Epoll:
+            std::cout << "[ES] Concurrency: epoll\n";
+            reactor_run(g_tcp_sock, loop_udp, g_verbose);
+            break;
+        case ConcurrencyModel::Prefork:
+            std::cout << "[ES] Concurrency: prefork (" << cfg.workers << " workers)\n";
+            prefork_run(g_tcp_sock, loop_udp, cfg.workers, g_verbose);
+            break;
+        case ConcurrencyModel::Threads:
+            std::cout << "[ES] Concurrency: threads (" << cfg.workers
+                      << " workers, queue " << cfg.queue_size << ")\n";
+            threads_run(g_tcp_sock, loop_udp, cfg.workers, cfg.queue_size, g_verbose);
+            break;
+        default:
+            break;
+        }
+
+        if (g_udp_sock != -1) ::close(g_udp_sock);
+        if (g_tcp_sock != -1) ::close(g_tcp_sock);
+        return 1;
+    }
 
     while (true) {
         fd_set readfds;
         FD_ZERO(&readfds);
-        FD_SET(g_udp_sock, &readfds);
+        if (loop_udp >= 0) FD_SET(loop_udp, &readfds);
         FD_SET(g_tcp_sock, &readfds);
 
-        int maxfd = (g_udp_sock > g_tcp_sock) ? g_udp_sock : g_tcp_sock;
+        int maxfd = (loop_udp > g_tcp_sock) ? loop_udp : g_tcp_sock;
 
         int ready = ::select(maxfd + 1, &readfds, nullptr, nullptr, nullptr);
         if (ready < 0) {
@@ -101,13 +249,13 @@ int main(int argc, char **argv)
         }
 
         // UDP pronto
-        if (FD_ISSET(g_udp_sock, &readfds)) {
-            udp_handle_datagram(g_udp_sock, g_verbose);
+        if (loop_udp >= 0 && FD_ISSET(loop_udp, &readfds)) {
+            udp_handle_ready(loop_udp, g_verbose);
         }
 
         // Nova ligação TCP pronta
         if (FD_ISSET(g_tcp_sock, &readfds)) {
-            tcp_accept_and_fork(g_tcp_sock, g_udp_sock, g_verbose);
+            tcp_accept_and_fork(g_tcp_sock, loop_udp, g_verbose);
         }
     }
 
@@ -3,20 +3,61 @@
 #include <cstdlib>
 #include <cstring>
 #include <getopt.h>
+#include "udp_handler.h"
+#include "desc_cache.h"
+#include <unistd.h>
+
+static void usage(const char *prog)
+{
+    std::cerr << "Usage: " << prog
+              << " [-v] [-p ESport] [-c|--concurrency fork|epoll|prefork|threads]"
+                 " [-w|--workers N] [-q|--queue-size N] [-u|--udp-shards N]"
+                 " [-b|--udp-batch N] [-i|--io-uring] [-s|--storage files|wal]"
+                 " [--convert-events] [--desc-cache-mb N]\n";
+    std::exit(EXIT_FAILURE);
+}
 
 void parse_server_args(ServerConfig &cfg, int argc, char **argv)
 {
     // defaults
     cfg.verbose = false;
     cfg.port    = 58000 + GN;  
+    cfg.concurrency = ConcurrencyModel::Fork;
+    cfg.queue_size  = 128;
+
+    long ncpu = ::sysconf(_SC_NPROCESSORS_ONLN);
+    cfg.workers = (ncpu > 0) ? static_cast<std::size_t>(ncpu) : 1;
+    cfg.udp_shards = cfg.workers;
+    cfg.udp_batch  = 32;
+    cfg.io_uring   = false;
+    cfg.storage    = StorageBackend::Files;
+    cfg.convert_events = false;
+    cfg.desc_cache_mb  = DESC_CACHE_DEFAULT_MB;
+
+    static const struct option long_opts[] = {
+        {"concurrency", required_argument, nullptr, 'c'},
+        {"workers",     required_argument, nullptr, 'w'},
+        {"queue-size",  required_argument, nullptr, 'q'},
+        {"udp-shards",  required_argument, nullptr, 'u'},
+        {"udp-batch",   required_argument, nullptr, 'b'},
+        {"io-uring",    no_argument,       nullptr, 'i'},
+        {"storage",     required_argument, nullptr, 's'},
+        {"convert-events", no_argument,    nullptr, 'E'},
+        {"desc-cache-mb",  required_argument, nullptr, 'D'},
+        {nullptr, 0, nullptr, 0}
+    };
 
     int opt;
-    while ((opt = ::getopt(argc, argv, "vp:")) != -1) {
+    while ((opt = ::getopt_long(argc, argv, "vip:c:w:q:u:b:s:", long_opts, nullptr)) != -1) {
         switch (opt) {
         case 'v':
             cfg.verbose = true;
             break;
 
+        case 'i':
+            cfg.io_uring = true;
+            break;
+
         case 'p': {
             int p = std::atoi(optarg);
             if (p <= 0 || p > 65535) {
@@ -27,9 +68,75 @@ void parse_server_args(ServerConfig &cfg, int argc, char **argv)
             break;
         }
 
+        case 'c':
+            if (std::strcmp(optarg, "fork") == 0) {
+                cfg.concurrency = ConcurrencyModel::Fork;
+            } else if (std::strcmp(optarg, "epoll") == 0) {
+                cfg.concurrency = ConcurrencyModel::Epoll;
+            } else if (std::strcmp(optarg, "prefork") == 0) {
+                cfg.concurrency = ConcurrencyModel::Prefork;
+            } else if (std::strcmp(optarg, "threads") == 0) {
+                cfg.concurrency = ConcurrencyModel::Threads;
+            } else {
+                std::cerr << "Invalid concurrency model: " << optarg << "\n";
+                usage(argv[0]);
+            }
+            break;
+
+        case 'E':
+            cfg.convert_events = true;
+            break;
+
+        case 'D': {
+            int n = std::atoi(optarg);
+            if (n < 0 || n > 4096 || (n == 0 && std::strcmp(optarg, "0") != 0)) {
+                std::cerr << "Invalid description cache size (0..4096 MB): "
+                          << optarg << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+            cfg.desc_cache_mb = static_cast<std::size_t>(n);
+            break;
+        }
+
+        case 's':
+            if (std::strcmp(optarg, "files") == 0) {
+                cfg.storage = StorageBackend::Files;
+            } else if (std::strcmp(optarg, "wal") == 0) {
+                cfg.storage = StorageBackend::Wal;
+            } else {
+                std::cerr << "Invalid storage backend: " << optarg << "\n";
+                usage(argv[0]);
+            }
+            break;
+
+        case 'b': {
+            int n = std::atoi(optarg);
+            if (n <= 0 || n > static_cast<int>(UDP_MAX_BATCH)) {
+                std::cerr << "Invalid UDP batch size (1.." << UDP_MAX_BATCH
+                          << "): " << optarg << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+            cfg.udp_batch = static_cast<std::size_t>(n);
+            break;
+        }
+
+        case 'w':
+        case 'q':
+        case 'u': {
+            int n = std::atoi(optarg);
+            if (n <= 0 || n > 4096) {
+                std::cerr << "Invalid value for -" << static_cast<char>(opt)
+                          << ": " << optarg << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+            if (opt == 'w')      cfg.workers    = static_cast<std::size_t>(n);
+            else if (opt == 'q') cfg.queue_size = static_cast<std::size_t>(n);
+            else                 cfg.udp_shards = static_cast<std::size_t>(n);
+            break;
+        }
+
         default:
-            std::cerr << "Usage: " << argv[0] << " [-v] [-p ESport]\n";
-            std::exit(EXIT_FAILURE);
+            usage(argv[0]);
         }
     }
 }
@@ -1,13 +1,37 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <cstddef>
 #include <cstdint>
 
 #define GN 5
 
+// Modelo de concorrência do servidor
+enum class ConcurrencyModel {
+    Fork,     // select() + fork() por ligação TCP
+    Epoll,    // um só processo, event loop epoll
+    Prefork,  // N processos pré-criados a partilhar o socket de escuta
+    Threads   // pool de N threads com fila limitada
+};
+
+// Armazenamento da BD
+enum class StorageBackend {
+    Files,    // árvore EVENTS/ + USERS/ (um ficheiro por registo)
+    Wal       // log só de acréscimo + índice em memória (DB/)
+};
+
 struct ServerConfig {
     bool        verbose;
     std::uint16_t port;   // porto ES (TCP+UDP)
+    ConcurrencyModel concurrency;
+    std::size_t workers;     // processos/threads (prefork/threads)
+    std::size_t queue_size;  // fila de trabalho (threads)
+    std::size_t udp_shards;  // sockets UDP SO_REUSEPORT, uma thread cada
+    std::size_t udp_batch;   // datagramas por recvmmsg/sendmmsg
+    bool        io_uring;    // backend io_uring (se compilado com IO_URING=1)
+    StorageBackend storage;
+    bool        convert_events;  // --convert-events: cria EVENT.bin e sai
+    std::size_t desc_cache_mb;   // cache de descrições do SED (0 = desligada)
 };
 
 // Lê argc/argv, aplica defaults e valida.
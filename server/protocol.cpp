@@ -1,9 +1,9 @@
 #include "protocol.h"
+#include "datetime.h"
 #include <cctype>
-#include <cstdio>
 
 // UID: 6 dígitos
-bool proto_valid_uid(const std::string &uid)
+bool proto_valid_uid(std::string_view uid)
 {
     if (uid.size() != UID_LEN) return false;
     for (char c : uid) {
@@ -14,7 +14,7 @@ bool proto_valid_uid(const std::string &uid)
 }
 
 // Password: 8 alfanuméricos
-bool proto_valid_password(const std::string &pass)
+bool proto_valid_password(std::string_view pass)
 {
     if (pass.size() != PASSWORD_LEN) return false;
     for (char c : pass) {
@@ -25,7 +25,7 @@ bool proto_valid_password(const std::string &pass)
 }
 
 // Nome do evento: 1..10 alfanuméricos
-bool proto_valid_event_name(const std::string &name)
+bool proto_valid_event_name(std::string_view name)
 {
     if (name.empty() || name.size() > EVENT_NAME_MAX) return false;
     for (char c : name) {
@@ -36,7 +36,7 @@ bool proto_valid_event_name(const std::string &name)
 }
 
 
-bool proto_valid_fname(const std::string &fname)
+bool proto_valid_fname(std::string_view fname)
 {
     if (fname.empty() || fname.size() > FNAME_MAX) return false;
 
@@ -49,7 +49,7 @@ bool proto_valid_fname(const std::string &fname)
 
     // verificar extensão .xxx
     auto pos = fname.rfind('.');
-    if (pos == std::string::npos) return false;
+    if (pos == std::string_view::npos) return false;
     if (pos + 4 != fname.size()) return false; // '.' + 3 letras
 
     for (std::size_t i = pos + 1; i < fname.size(); ++i) {
@@ -61,7 +61,7 @@ bool proto_valid_fname(const std::string &fname)
 }
 
 // EID: 3 dígitos
-bool proto_valid_eid(const std::string &eid)
+bool proto_valid_eid(std::string_view eid)
 {
     if (eid.size() != 3) return false;
     for (char c : eid) {
@@ -72,7 +72,7 @@ bool proto_valid_eid(const std::string &eid)
 }
 
 // "dd-mm-yyyy"
-bool proto_valid_date_ddmmyyyy(const std::string &date)
+bool proto_valid_date_ddmmyyyy(std::string_view date)
 {
     if (date.size() != 10) return false;
     if (date[2] != '-' || date[5] != '-') return false;
@@ -86,7 +86,7 @@ bool proto_valid_date_ddmmyyyy(const std::string &date)
 }
 
 // "hh:mm"
-bool proto_valid_time_hhmm(const std::string &time)
+bool proto_valid_time_hhmm(std::string_view time)
 {
     if (time.size() != 5) return false;
     if (time[2] != ':') return false;
@@ -100,7 +100,7 @@ bool proto_valid_time_hhmm(const std::string &time)
 }
 
 // "dd-mm-yyyy hh:mm:ss"
-bool proto_valid_datetime_with_seconds(const std::string &dt)
+bool proto_valid_datetime_with_seconds(std::string_view dt)
 {
     if (dt.size() != 19) return false;
     if (dt[2] != '-' || dt[5] != '-' || dt[10] != ' ' ||
@@ -115,6 +115,25 @@ bool proto_valid_datetime_with_seconds(const std::string &dt)
     return true;
 }
 
+// UDP: tokens sobre o buffer do datagrama
+void udp_tokenize(const char *buf, std::size_t len, UdpTokens &t)
+{
+    auto is_space = [](char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    };
+
+    t.n = 0;
+    std::size_t i = 0;
+    while (t.n < UDP_MAX_TOKENS) {
+        while (i < len && is_space(buf[i])) ++i;
+        if (i >= len) break;
+
+        const std::size_t start = i;
+        while (i < len && !is_space(buf[i])) ++i;
+        t.tok[t.n++] = std::string_view(buf + start, i - start);
+    }
+}
+
 // Parse "dd-mm-yyyy hh:mm:ss" -> time_t
 std::time_t proto_parse_datetime_with_seconds(const std::string &s)
 {
@@ -122,19 +141,6 @@ std::time_t proto_parse_datetime_with_seconds(const std::string &s)
         return 0;
     }
 
-    int d=0, m=0, y=0, H=0, M=0, S=0;
-    if (std::sscanf(s.c_str(), "%2d-%2d-%4d %2d:%2d:%2d",
-                    &d,&m,&y,&H,&M,&S) != 6) {
-        return 0;
-    }
-
-    std::tm tm{};
-    tm.tm_mday = d;
-    tm.tm_mon  = m - 1;
-    tm.tm_year = y - 1900;
-    tm.tm_hour = H;
-    tm.tm_min  = M;
-    tm.tm_sec  = S;
-
-    return std::mktime(&tm);
+    std::time_t t = 0;
+    return dt_parse_seconds(s, t) ? t : 0;
 }
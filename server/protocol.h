@@ -1,5 +1,7 @@
 #pragma once
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <ctime>
 
@@ -13,32 +15,47 @@ constexpr int MIN_ATTENDANCE       = 10;         // 10..999
 constexpr int MAX_ATTENDANCE       = 999;
 constexpr int MAX_RESERVE_PEOPLE   = 999;        // 1..999
 constexpr int MAX_FILE_SIZE_BYTES  = 10'000'000; // 10 MB
+constexpr int LMR_MAX_RESERVATIONS = 50;         // RMR: só as 50 mais recentes
+constexpr int LSX_MAX_PAGE         = 100;        // LSX: eventos por página
 
 // Funções de validação
 
 // UID: exatamente 6 dígitos
-bool proto_valid_uid(const std::string &uid);
+bool proto_valid_uid(std::string_view uid);
 
 // Password: exatamente 8 caracteres alfanuméricos
-bool proto_valid_password(const std::string &pass);
+bool proto_valid_password(std::string_view pass);
 
 // Nome de evento: 1..10 caracteres alfanuméricos
-bool proto_valid_event_name(const std::string &name);
+bool proto_valid_event_name(std::string_view name);
 
 // Nome de ficheiro: 1..24 chars, [A-Za-z0-9._-], extensão .xxx (3 letras)
-bool proto_valid_fname(const std::string &fname);
+bool proto_valid_fname(std::string_view fname);
 
 // EID: exatamente 3 dígitos
-bool proto_valid_eid(const std::string &eid);
+bool proto_valid_eid(std::string_view eid);
 
 // Data: "dd-mm-yyyy"
-bool proto_valid_date_ddmmyyyy(const std::string &date);
+bool proto_valid_date_ddmmyyyy(std::string_view date);
 
 // Hora: "hh:mm"
-bool proto_valid_time_hhmm(const std::string &time);
+bool proto_valid_time_hhmm(std::string_view time);
 
 // Datetime com segundos: "dd-mm-yyyy hh:mm:ss"
-bool proto_valid_datetime_with_seconds(const std::string &dt);
+bool proto_valid_datetime_with_seconds(std::string_view dt);
+
+// Tokens de um pedido UDP, sobre o próprio buffer do datagrama (sem
+// cópias). Nenhum comando UDP tem mais de 2 campos: um 4.º token basta
+// para saber que o pedido está mal formado.
+constexpr std::size_t UDP_MAX_TOKENS = 4;
+
+struct UdpTokens {
+    std::string_view tok[UDP_MAX_TOKENS];
+    std::size_t      n = 0;
+};
+
+// Separa por espaço/tab/'\r'/'\n' (como o operator>>)
+void udp_tokenize(const char *buf, std::size_t len, UdpTokens &t);
 
 // Parse de datetime com segundos (retorna 0 em caso de erro)
 // Formato esperado: "dd-mm-yyyy hh:mm:ss"
@@ -0,0 +1,254 @@
+// server/reactor.cpp
+#include "reactor.h"
+#include "tcp_handler.h"
+#include "udp_handler.h"
+#include "protocol.h"
+#include "datetime.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// maior pedido aceite: header CRE + Fdata máximo + terminador
+static const std::size_t MAX_REQUEST_BYTES = MAX_FILE_SIZE_BYTES + 1024;
+
+// Estado de uma ligação TCP.
+//  Reading: acumula bytes até haver um pedido completo
+//  Writing: resposta pronta, a enviar à medida que o socket deixa
+//           (o cursor de envio vive no próprio TcpReply)
+struct Connection {
+    enum class State { Reading, Writing };
+
+    int         fd = -1;
+    std::string ip;
+    uint16_t    port = 0;
+    State       state = State::Reading;
+    bool        peer_eof = false;
+
+    bool        keep_alive = false;   // negociado com KAL
+    std::time_t last_active = 0;      // último byte lido ou envio que avançou
+
+    std::string in;
+    TcpReply    out;
+};
+
+static bool set_nonblocking(int fd)
+{
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return false;
+    return ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Faz a ligação avançar: envia a resposta pendente e trata os pedidos
+// completos que já estejam em c.in (com KAL podem vir vários seguidos).
+// Devolve false se a ligação deve fechar.
+static bool conn_advance(Connection &c, bool verbose)
+{
+    while (true) {
+        if (c.state == Connection::State::Writing) {
+            int r = tcp_reply_send_some(c.fd, c.out);
+            if (r <= 0) return r == 0;
+
+            // sem KAL: um comando por ligação (como no modo fork)
+            if (!c.keep_alive) return false;
+
+            c.out.reset();
+            c.state = Connection::State::Reading;
+        }
+
+        std::size_t frame = tcp_request_frame_length(c.in.data(), c.in.size());
+        if (frame == 0) {
+            if (!c.peer_eof && c.in.size() <= MAX_REQUEST_BYTES) return true;
+            if (c.in.empty()) return false;   // EOF entre pedidos
+            frame = c.in.size();
+        }
+
+        tcp_handle_request(c.in.data(), frame, verbose,
+                           c.ip.c_str(), c.port, c.out, c.keep_alive);
+        c.in.erase(0, frame);
+        if (c.in.empty()) c.in.shrink_to_fit();
+
+        if (c.out.empty()) return false;
+        c.state = Connection::State::Writing;
+    }
+}
+
+// Lê tudo o que houver e faz a ligação avançar.
+// Devolve false se a ligação deve fechar.
+static bool conn_on_readable(Connection &c, bool verbose)
+{
+    char buf[64 * 1024];
+
+    while (true) {
+        ssize_t r = ::read(c.fd, buf, sizeof(buf));
+        if (r > 0) {
+            // sem KAL, o que chega depois do pedido é ignorado
+            if (c.state == Connection::State::Reading || c.keep_alive) {
+                c.in.append(buf, static_cast<std::size_t>(r));
+            }
+            continue;
+        }
+        if (r == 0) { c.peer_eof = true; break; }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        return false;
+    }
+
+    // cliente a encher o pipeline sem ler respostas
+    if (c.in.size() > 2 * MAX_REQUEST_BYTES) return false;
+
+    c.last_active = dt_now();
+    return conn_advance(c, verbose);
+}
+
+static void accept_all(int epfd, int listen_fd, bool verbose,
+                       std::unordered_map<int, std::unique_ptr<Connection>> &conns)
+{
+    while (true) {
+        struct sockaddr_in cli{};
+        socklen_t len = sizeof(cli);
+
+        int cfd = ::accept4(listen_fd, (struct sockaddr*)&cli, &len,
+                            SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (cfd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) std::perror("accept");
+            return;
+        }
+
+        char ip[INET_ADDRSTRLEN] = "?";
+        ::inet_ntop(AF_INET, &cli.sin_addr, ip, sizeof(ip));
+
+        if (verbose) {
+            std::cout << "[ES][TCP] Accepted connection from "
+                      << ip << ":" << ntohs(cli.sin_port)
+                      << " (fd=" << cfd << ")\n";
+        }
+
+        auto c = std::make_unique<Connection>();
+        c->fd   = cfd;
+        c->ip   = ip;
+        c->port = ntohs(cli.sin_port);
+        c->last_active = dt_now();
+
+        struct epoll_event ev{};
+        ev.events  = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = cfd;
+        if (::epoll_ctl(epfd, EPOLL_CTL_ADD, cfd, &ev) < 0) {
+            std::perror("epoll_ctl(client)");
+            ::close(cfd);
+            continue;
+        }
+        conns[cfd] = std::move(c);
+    }
+}
+
+int reactor_run(int listen_fd, int udp_fd, bool verbose)
+{
+    if (!set_nonblocking(listen_fd) || (udp_fd >= 0 && !set_nonblocking(udp_fd))) {
+        std::perror("fcntl(O_NONBLOCK)");
+        return -1;
+    }
+
+    int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        std::perror("epoll_create1");
+        return -1;
+    }
+
+    for (int fd : {listen_fd, udp_fd}) {
+        if (fd < 0) continue;   // UDP tratado pelos shards
+        struct epoll_event ev{};
+        ev.events  = EPOLLIN | EPOLLET;
+        ev.data.fd = fd;
+        if (::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            std::perror("epoll_ctl");
+            ::close(epfd);
+            return -1;
+        }
+    }
+
+    std::unordered_map<int, std::unique_ptr<Connection>> conns;
+    struct epoll_event events[128];
+    std::time_t last_sweep = 0;
+
+    while (true) {
+        int n = ::epoll_wait(epfd, events, 128, 1000);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            const int fd = events[i].data.fd;
+            const uint32_t evs = events[i].events;
+
+            if (udp_fd >= 0 && fd == udp_fd) {
+                // edge-triggered: esvaziar a fila
+                while (udp_handle_ready(udp_fd, verbose) > 0) {}
+                continue;
+            }
+
+            if (fd == listen_fd) {
+                accept_all(epfd, listen_fd, verbose, conns);
+                continue;
+            }
+
+            auto it = conns.find(fd);
+            if (it == conns.end()) continue;
+            Connection &c = *it->second;
+
+            bool keep = !(evs & EPOLLERR);
+            if (keep && (evs & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))) {
+                keep = conn_on_readable(c, verbose);
+            }
+            if (keep && (evs & EPOLLOUT) &&
+                c.state == Connection::State::Writing) {
+                // edge-triggered: o socket esvaziou, o cliente está a ler
+                c.last_active = dt_now();
+                keep = conn_advance(c, verbose);
+            }
+
+            if (!keep) {
+                ::epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+                ::close(fd);
+                conns.erase(it);
+            }
+        }
+
+        // ligações paradas há demasiado tempo: KAL sem pedidos, mas também
+        // quem nunca manda o pedido (ou o deixa a meio) e quem não lê a
+        // resposta; senão ficavam abertas para sempre
+        const std::time_t now = dt_now();
+        if (now != last_sweep) {
+            last_sweep = now;
+            for (auto it = conns.begin(); it != conns.end(); ) {
+                const Connection &c = *it->second;
+                if (now - c.last_active >= TCP_IDLE_SEC) {
+                    ::epoll_ctl(epfd, EPOLL_CTL_DEL, it->first, nullptr);
+                    ::close(it->first);
+                    it = conns.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    for (auto &kv : conns) ::close(kv.first);
+    ::close(epfd);
+    return -1;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// Event loop epoll (edge-triggered, sockets não bloqueantes).
+// Trata o socket de escuta TCP, o socket UDP e todas as ligações
+// de clientes no mesmo processo, sem fork.
+// udp_fd < 0: UDP tratado noutro sítio (shards).
+// Só retorna em caso de erro fatal (devolve -1).
+int reactor_run(int listen_fd, int udp_fd, bool verbose);
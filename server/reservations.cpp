@@ -2,12 +2,24 @@
 #include "users.h"
 #include "events.h"
 #include "utils.h"
+#include "io_backend.h"
+#include "protocol.h"
+#include "wal.h"
+#include "datetime.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <string>
 #include <ctime>
-#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
@@ -16,88 +28,136 @@ static std::string res_file(const std::string &eid) {
     return event_dir(eid) + "/RES " + eid + ".txt";
 }
 
+// Índice das reservas do utilizador: USERS/uid/RESERVED/.index
+// Uma linha "EID nome_do_ficheiro" por reserva, acrescentada com O_APPEND
+// (RIDs do mesmo utilizador em eventos diferentes não partilham lock).
+static std::string reserved_index_path(const std::string &uid) {
+    return "USERS/" + uid + "/RESERVED/.index";
+}
 
-static bool write_int_file(const std::string &path, int value)
+static bool append_reserved_index(const std::string &uid, const std::string &eid,
+                                  const std::string &filename)
 {
-    std::ofstream out(path);
-    if (!out.is_open()) return false;
-    out << value << "\n";
-    return out.good();
+    int fd = ::open(reserved_index_path(uid).c_str(),
+                    O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    const std::string line = eid + " " + filename + "\n";
+    bool ok = write_exact(fd, line.data(), line.size());
+    ::close(fd);
+    return ok;
 }
 
-// Gera o nome do ficheiro de reserva e a string data/hora a escrever
-//  - filename: R-UID-YYYY-MM-DD HHMMSS.txt
-//  - datetime_str: DD-MM-YYYY HH:MM:SS
-static void make_reservation_names(const std::string &uid,
-                                   std::string &filename_out,
-                                   std::string &datetime_str_out)
+// Vista das reservas mais recentes: USERS/uid/RECENT
+// Até LMR_MAX_RESERVATIONS linhas "EID dd-mm-yyyy hh:mm:ss seats", da mais
+// recente para a mais antiga. Só muda com o lock do utilizador, que também
+// cobre a escrita dos ficheiros de reserva (assim a reconstrução não perde
+// nem duplica uma reserva a meio).
+static std::string recent_path(const std::string &uid) {
+    return "USERS/" + uid + "/RECENT";
+}
+
+static std::string user_lock_path(const std::string &uid) {
+    return "USERS/" + uid + "/.lock";
+}
+
+static void parse_recent(const std::string &data, std::vector<ReservationRecord> &out)
 {
-    std::time_t now = std::time(nullptr);
-    std::tm *lt = std::localtime(&now);
-    if (!lt) {
-        filename_out.clear();
-        datetime_str_out.clear();
-        return;
+    out.clear();
+    std::istringstream in(data);
+    std::string eid, d, t;
+    int seats = 0;
+    while (in >> eid >> d >> t >> seats) {
+        ReservationRecord r;
+        r.eid      = eid;
+        r.datetime = d + " " + t;
+        r.seats    = seats;
+        out.push_back(std::move(r));
     }
+}
 
-    char date_file[11];     // YYYY-MM-DD
-    char time_file[7];      // HHMMSS
-    char datetime[20];      // DD-MM-YYYY HH:MM:SS
+static std::string format_recent(const std::vector<ReservationRecord> &recent)
+{
+    std::string data;
+    for (const auto &r : recent) {
+        data += r.eid + " " + r.datetime + " " + std::to_string(r.seats) + "\n";
+    }
+    return data;
+}
 
-    std::strftime(date_file, sizeof(date_file), "%Y-%m-%d", lt);
-    std::strftime(time_file, sizeof(time_file), "%H%M%S", lt);
-    std::strftime(datetime, sizeof(datetime), "%d-%m-%Y %H:%M:%S", lt);
+// Acrescenta uma reserva à vista, se ela já existir (senão fica para a
+// reconstrução no próximo LMR). Com o lock do utilizador.
+static void update_recent_locked(const std::string &uid, ReservationRecord r)
+{
+    std::string data;
+    if (!io_read_file(recent_path(uid), data)) return;
+
+    std::vector<ReservationRecord> recent;
+    parse_recent(data, recent);
+
+    // normalmente entra no topo; RIDs simultâneos podem chegar trocados
+    const std::time_t ts = proto_parse_datetime_with_seconds(r.datetime);
+    auto it = recent.begin();
+    while (it != recent.end() && proto_parse_datetime_with_seconds(it->datetime) > ts) ++it;
+    recent.insert(it, std::move(r));
+    if (recent.size() > static_cast<std::size_t>(LMR_MAX_RESERVATIONS)) {
+        recent.resize(LMR_MAX_RESERVATIONS);
+    }
 
-    filename_out = "R-" + uid + "-" + std::string(date_file) +
-                   " " + std::string(time_file) + ".txt";
-    datetime_str_out = datetime;
+    if (!write_file_atomic(recent_path(uid), format_recent(recent))) {
+        // vista desactualizada é pior do que nenhuma
+        ::unlink(recent_path(uid).c_str());
+    }
 }
 
-// Se o evento já passou mas ainda não tem END então 
-// criamos END EID.txt com a data/hora de ocorrência (igual à do evento).
-static void maybe_create_end_for_past_event(const std::string &eid,
-                                            const std::string &event_date_str)
+// nome do ficheiro -> EID
+static void load_reserved_index(const std::string &uid,
+                                std::unordered_map<std::string, std::string> &idx)
 {
-    // Se já existir END, não fazemos nada.
-    std::string end_path = event_dir(eid) + "/END " + eid + ".txt";
-    {
-        std::ifstream test(end_path);
-        if (test.is_open()) return;
+    std::string data;
+    if (!io_read_file(reserved_index_path(uid), data)) return;
+
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+        std::size_t nl = data.find('\n', pos);
+        if (nl == std::string::npos) break;   // linha a meio de ser escrita
+        if (nl - pos > 4 && data[pos + 3] == ' ') {
+            idx[data.substr(pos + 4, nl - pos - 4)] = data.substr(pos, 3);
+        }
+        pos = nl + 1;
     }
+}
 
-    // event_date_str vem no formato "dd-mm-yyyy hh:mm"
-    int day=0, month=0, year=0, hour=0, min=0;
-    if (std::sscanf(event_date_str.c_str(), "%2d-%2d-%4d %2d:%2d",
-                    &day, &month, &year, &hour, &min) != 5) {
-        return;
-    }
 
-    std::tm tm_end{};
-    tm_end.tm_mday = day;
-    tm_end.tm_mon  = month - 1;
-    tm_end.tm_year = year - 1900;
-    tm_end.tm_hour = hour;
-    tm_end.tm_min  = min;
-    tm_end.tm_sec  = 0;
+// Gera o nome do ficheiro de reserva e a string data/hora a escrever
+//  - filename: R-UID-YYYY-MM-DD HHMMSS.txt
+//  - datetime_str: DD-MM-YYYY HH:MM:SS
+static void make_reservation_names(const std::string &uid,
+                                   std::string &filename_out,
+                                   std::string &datetime_str_out)
+{
+    const std::time_t now = dt_now();
 
-    char buf[32];
-    if (std::strftime(buf, sizeof(buf), "%d-%m-%Y %H:%M:%S", &tm_end) == 0) {
-        return;
-    }
+    char file_part[DT_FILE_LEN + 1];      // YYYY-MM-DD HHMMSS
+    char datetime[DT_SECONDS_LEN + 1];    // DD-MM-YYYY HH:MM:SS
 
-    std::ofstream out(end_path);
-    if (!out.is_open()) return;
+    dt_format_file(now, file_part);
+    dt_format_seconds(now, datetime);
 
-    out << buf << "\n";
+    filename_out = "R-" + uid + "-" + file_part + ".txt";
+    datetime_str_out = datetime;
 }
 
-
 ReserveStatus es_make_reservation(const std::string &uid,
                                   const std::string &pass,
                                   const std::string &eid,
                                   int people,
                                   int &remaining_out)
 {
+    if (wal_enabled()) {
+        return wal_make_reservation(uid, pass, eid, people, remaining_out);
+    }
+
     remaining_out = 0;
 
     //  Validar utilizador 
@@ -113,17 +173,24 @@ ReserveStatus es_make_reservation(const std::string &uid,
         return ReserveStatus::WRP;
     }
 
+    // A partir daqui: ler RES, comparar e reescrever tem de ser atómico.
+    // O lock é só deste evento: RIDs noutros eventos seguem em paralelo.
+    FsLock lock(event_lock_path(eid).c_str());
+    if (!lock.ok()) {
+        // sem EVENTS/eid: evento não existe
+        return ReserveStatus::NOK;
+    }
+
     //  Carregar evento 
     EventInfo ev;
-    if (!load_event(eid, ev)) {
+    if (!load_event_fresh(eid, ev)) {
         // evento não existe ou START mal formado
         return ReserveStatus::NOK;
     }
 
-    // Verificar estado
-    // Se o evento já for passado, podemos ainda criar o END se não existir
+    // Verificar estado (o END de um evento passado é escrito pelo
+    // agendador de expiração, não aqui)
     if (ev.state == EventState::Past) {
-        maybe_create_end_for_past_event(eid, ev.event_date);
         return ReserveStatus::PST;
     }
 
@@ -155,11 +222,6 @@ ReserveStatus es_make_reservation(const std::string &uid,
     //  Podem reservar
     int new_total = total_reserved + people;
 
-    // actualizar RES EID.txt
-    if (!write_int_file(res_file(eid), new_total)) {
-        return ReserveStatus::NOK;
-    }
-
     // Gerar nomes para ficheiros de reserva
     std::string filename;        // R-UID-YYYY-MM-DD HHMMSS.txt
     std::string datetime_str;    // DD-MM-YYYY HH:MM:SS
@@ -173,29 +235,253 @@ ReserveStatus es_make_reservation(const std::string &uid,
     fs::create_directories(event_dir(eid) + "/RESERVATIONS", ec);
     fs::create_directories("USERS/" + uid + "/RESERVED", ec);
 
-    // Ficheiro EVENTS/eid/RESERVATIONS/R-uid-date time.txt
-    {
-        std::string path = event_dir(eid) + "/RESERVATIONS/" + filename;
-        std::ofstream out(path);
-        if (!out.is_open())
-            return ReserveStatus::NOK;
-
-        //UID res_num res_datetime
-        out << uid << " " << people << " " << datetime_str << "\n";
-        if (!out.good())
-            return ReserveStatus::NOK;
+    // índice, ficheiros de reserva e RECENT de uma vez, para quem lê a vista
+    FsLock user_lock(user_lock_path(uid).c_str());
+    if (!user_lock.ok()) {
+        return ReserveStatus::NOK;
     }
 
-    {
-        std::string path = "USERS/" + uid + "/RESERVED/" + filename;
-        std::ofstream out(path);
-        if (!out.is_open())
-            return ReserveStatus::NOK;
+    // índice primeiro: uma entrada sem ficheiro é ignorada pelo LMR,
+    // um ficheiro sem entrada obrigava a procurar em EVENTS/*
+    if (!append_reserved_index(uid, eid, filename))
+        return ReserveStatus::NOK;
 
-        out << uid << " " << people << " " << datetime_str << "\n";
-        if (!out.good())
-            return ReserveStatus::NOK;
+    //UID res_num res_datetime
+    const std::string record = uid + " " + std::to_string(people) + " " +
+                               datetime_str + "\n";
+
+    EventInfo updated = ev;
+    updated.reserved = new_total;
+
+    // EVENT.bin é a única fonte de "reserved" e é escrito depois dos
+    // ficheiros da reserva: se falhar, a reserva é desfeita e o total
+    // fica como estava. O RES é derivado dele (exportação) e vem no fim;
+    // se não for escrito, o próximo RID ou o -C reescrevem-no.
+    // Os dois ficheiros da reserva vão numa só submissão (io_uring).
+    const std::string paths[2] = {
+        event_dir(eid) + "/RESERVATIONS/" + filename,
+        "USERS/" + uid + "/RESERVED/" + filename
+    };
+    const std::string contents[2] = {record, record};
+    if (!io_write_files_atomic(paths, contents, 2)) {
+        ::unlink(paths[0].c_str());
+        ::unlink(paths[1].c_str());
+        return ReserveStatus::NOK;
+    }
+
+    // EVENT.bin é criado aqui se o evento ainda não o tinha
+    if (!io_write_file_atomic(event_record_path(eid), event_record_encode(updated))) {
+        ::unlink(paths[0].c_str());
+        ::unlink(paths[1].c_str());
+        return ReserveStatus::NOK;
     }
 
+    io_write_file_atomic(res_file(eid), std::to_string(new_total) + "\n");
+
+    ReservationRecord r;
+    r.eid      = eid;
+    r.datetime = datetime_str;
+    r.seats    = people;
+    update_recent_locked(uid, std::move(r));
+
     return ReserveStatus::ACC;
 }
+
+// procura em EVENTS/*/RESERVATIONS/ um ficheiro com o nome dado.
+// devolve true e eid_out se encontrar.
+static bool find_event_for_resfile(const std::string &res_filename,
+                                   std::string &eid_out)
+{
+    DIR *dir = ::opendir("EVENTS");
+    if (!dir) return false;
+
+    struct dirent *ent;
+    while ((ent = ::readdir(dir)) != nullptr) {
+        if (ent->d_name[0] == '.') continue;
+        // directorias de 3 dígitos
+        if (std::strlen(ent->d_name) != 3) continue;
+
+        std::string eid = ent->d_name;
+        std::string path =
+            "EVENTS/" + eid + "/RESERVATIONS/" + res_filename;
+
+        if (file_exists(path)) {
+            ::closedir(dir);
+            eid_out = eid;
+            return true;
+        }
+    }
+
+    ::closedir(dir);
+    return false;
+}
+
+bool es_user_reservations(const std::string &uid,
+                          std::vector<ReservationRecord> &out)
+{
+    if (wal_enabled()) return wal_user_reservations(uid, out);
+
+    out.clear();
+
+    std::string reserved_dir = "USERS/" + uid + "/RESERVED";
+    DIR *dir = ::opendir(reserved_dir.c_str());
+    if (!dir) {
+        // não há diretoria RESERVED → sem reservas
+        return false;
+    }
+
+    std::unordered_map<std::string, std::string> index;
+    load_reserved_index(uid, index);
+
+    struct dirent *ent;
+    while ((ent = ::readdir(dir)) != nullptr) {
+        if (ent->d_name[0] == '.') continue;
+
+        std::string fname = ent->d_name; // ex: R-111111-2025-12-05 153000.txt
+
+        // EID correspondente: pelo índice; se faltar (dados copiados à
+        // mão, por exemplo), procurar em EVENTS/*/RESERVATIONS/fname
+        std::string eid;
+        auto it = index.find(fname);
+        if (it != index.end()) {
+            eid = it->second;
+        } else if (!find_event_for_resfile(fname, eid)) {
+            continue; // ficheiro estranho/inconsistente
+        }
+
+        std::string path = reserved_dir + "/" + fname;
+        std::ifstream in(path);
+        if (!in.is_open()) continue;
+
+        std::string line;
+        if (!std::getline(in, line)) continue;
+
+        std::istringstream ls(line);
+        std::string file_uid;
+        int seats = 0;
+        std::string dt1, dt2;
+
+        // formato: UID res_num res_datetime
+        // res_datetime = "DD-MM-YYYY HH:MM:SS" -> dt1 + dt2
+        if (!(ls >> file_uid >> seats >> dt1 >> dt2)) {
+            continue;
+        }
+
+        if (file_uid != uid || seats < 1 || seats > MAX_RESERVE_PEOPLE) {
+            continue;
+        }
+
+        ReservationRecord r;
+        r.eid      = eid;
+        r.datetime = dt1 + " " + dt2;
+        r.seats    = seats;
+        out.push_back(std::move(r));
+    }
+
+    ::closedir(dir);
+    return true;
+}
+
+bool es_user_recent_reservations(const std::string &uid,
+                                 std::vector<ReservationRecord> &out)
+{
+    if (wal_enabled()) return wal_user_recent_reservations(uid, out);
+
+    // caminho normal: uma leitura, já ordenada
+    std::string data;
+    if (io_read_file(recent_path(uid), data)) {
+        parse_recent(data, out);
+        return true;
+    }
+
+    // ainda sem vista (BD antiga, ou primeiro LMR): reconstruir de RESERVED
+    FsLock lock(user_lock_path(uid).c_str());
+    if (!lock.ok()) return false;
+    if (io_read_file(recent_path(uid), data)) {
+        parse_recent(data, out);
+        return true;
+    }
+
+    std::vector<ReservationRecord> all;
+    if (!es_user_reservations(uid, all)) return false;
+
+    std::vector<std::pair<std::time_t, ReservationRecord>> by_time;
+    by_time.reserve(all.size());
+    for (auto &r : all) {
+        std::time_t ts = proto_parse_datetime_with_seconds(r.datetime);
+        if (ts == 0) continue;
+        by_time.emplace_back(ts, std::move(r));
+    }
+    std::stable_sort(by_time.begin(), by_time.end(),
+                     [](const auto &a, const auto &b) { return a.first > b.first; });
+    if (by_time.size() > static_cast<std::size_t>(LMR_MAX_RESERVATIONS)) {
+        by_time.resize(LMR_MAX_RESERVATIONS);
+    }
+
+    out.clear();
+    for (auto &p : by_time) out.push_back(std::move(p.second));
+
+    write_file_atomic(recent_path(uid), format_recent(out));
+    return true;
+}
+
+// Migração: BD criada antes do índice. Uma só passagem por
+// EVENTS/*/RESERVATIONS dá o EID de cada ficheiro de reserva.
+int es_reservations_backfill_index()
+{
+    std::vector<std::string> pending;   // UIDs com RESERVED mas sem .index
+
+    DIR *users = ::opendir("USERS");
+    if (!users) return 0;
+    struct dirent *ent;
+    while ((ent = ::readdir(users)) != nullptr) {
+        if (ent->d_name[0] == '.') continue;
+        const std::string uid = ent->d_name;
+        struct stat st{};
+        if (::stat(("USERS/" + uid + "/RESERVED").c_str(), &st) != 0 ||
+            !S_ISDIR(st.st_mode)) {
+            continue;
+        }
+        if (!file_exists(reserved_index_path(uid))) pending.push_back(uid);
+    }
+    ::closedir(users);
+
+    if (pending.empty()) return 0;
+
+    // ficheiro de reserva -> EID
+    std::unordered_map<std::string, std::string> owner;
+    DIR *events = ::opendir("EVENTS");
+    if (events) {
+        while ((ent = ::readdir(events)) != nullptr) {
+            if (ent->d_name[0] == '.' || std::strlen(ent->d_name) != 3) continue;
+            const std::string eid = ent->d_name;
+
+            DIR *rdir = ::opendir((event_dir(eid) + "/RESERVATIONS").c_str());
+            if (!rdir) continue;
+            struct dirent *r;
+            while ((r = ::readdir(rdir)) != nullptr) {
+                if (r->d_name[0] == '.') continue;
+                owner[r->d_name] = eid;
+            }
+            ::closedir(rdir);
+        }
+        ::closedir(events);
+    }
+
+    for (const auto &uid : pending) {
+        const std::string reserved_dir = "USERS/" + uid + "/RESERVED";
+        DIR *dir = ::opendir(reserved_dir.c_str());
+        if (!dir) continue;
+
+        std::string index;
+        while ((ent = ::readdir(dir)) != nullptr) {
+            if (ent->d_name[0] == '.') continue;
+            auto it = owner.find(ent->d_name);
+            if (it != owner.end()) index += it->second + " " + ent->d_name + "\n";
+        }
+        ::closedir(dir);
+
+        write_file_atomic(reserved_index_path(uid), index);
+    }
+    return static_cast<int>(pending.size());
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 enum class ReserveStatus {
     ACC,   // Reserva aceite
@@ -21,3 +22,26 @@ ReserveStatus es_make_reservation(const std::string &uid,
                                   const std::string &eid,
                                   int people_requested,
                                   int &remaining_out);
+
+// Uma reserva feita por um utilizador (LMR).
+struct ReservationRecord {
+    std::string eid;
+    std::string datetime;   // "dd-mm-yyyy hh:mm:ss"
+    int         seats = 0;
+};
+
+// Migração para o índice USERS/<uid>/RESERVED/.index (EID de cada
+// reserva, usado pelo LMR): cria-o para quem ainda não o tem.
+// Chamar no arranque, antes de servir pedidos. Devolve quantos criou.
+int es_reservations_backfill_index();
+
+// As LMR_MAX_RESERVATIONS reservas mais recentes, da mais recente para a
+// mais antiga (vista USERS/<uid>/RECENT, mantida pelo RID).
+// Devolve false se não houver registo de reservas.
+bool es_user_recent_reservations(const std::string &uid,
+                                 std::vector<ReservationRecord> &out);
+
+// Todas as reservas do utilizador, sem ordem definida.
+// Devolve false se não houver registo de reservas.
+bool es_user_reservations(const std::string &uid,
+                          std::vector<ReservationRecord> &out);
@@ -0,0 +1,155 @@
+// server/stats.cpp
+#include "stats.h"
+
+#include <iomanip>
+#include <new>
+
+#include <time.h>
+
+#include <sys/mman.h>
+
+static ServerStats  g_local_stats;      // fallback se o mmap falhar
+static ServerStats *g_stats = &g_local_stats;
+
+void stats_init()
+{
+    void *p = ::mmap(nullptr, sizeof(ServerStats), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return;
+    g_stats = new (p) ServerStats();
+}
+
+ServerStats &stats()
+{
+    return *g_stats;
+}
+
+void stats_udp_batch(std::size_t n, std::size_t cap)
+{
+    if (n == 0) return;
+    ServerStats &s = *g_stats;
+
+    s.udp_batches.fetch_add(1, std::memory_order_relaxed);
+    s.udp_datagrams.fetch_add(n, std::memory_order_relaxed);
+    if (n >= cap) s.udp_batch_full.fetch_add(1, std::memory_order_relaxed);
+
+    std::size_t bucket = 0;
+    for (std::size_t v = n - 1; v > 0; v >>= 1) ++bucket;
+    if (bucket >= ServerStats::BATCH_BUCKETS) bucket = ServerStats::BATCH_BUCKETS - 1;
+    s.udp_batch_hist[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void stats_catalog(bool hit)
+{
+    ServerStats &s = *g_stats;
+    if (hit) s.catalog_hits.fetch_add(1, std::memory_order_relaxed);
+    else     s.catalog_misses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void stats_desc_cache(bool hit, std::size_t bytes)
+{
+    ServerStats &s = *g_stats;
+    if (hit) {
+        s.desc_hits.fetch_add(1, std::memory_order_relaxed);
+        s.desc_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    } else {
+        s.desc_misses.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void stats_list_cache(bool hit)
+{
+    ServerStats &s = *g_stats;
+    if (hit) s.list_hits.fetch_add(1, std::memory_order_relaxed);
+    else     s.list_misses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void stats_command(CmdId id, std::uint64_t ns)
+{
+    ServerStats &s = *g_stats;
+    const std::size_t i = cmd_index(id);
+
+    s.cmd_requests[i].fetch_add(1, std::memory_order_relaxed);
+    s.cmd_ns[i].fetch_add(ns, std::memory_order_relaxed);
+
+    std::uint64_t max = s.cmd_max_ns[i].load(std::memory_order_relaxed);
+    while (ns > max &&
+           !s.cmd_max_ns[i].compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+}
+
+std::uint64_t stats_clock_ns()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000u +
+           static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+void stats_dump(std::ostream &out)
+{
+    const ServerStats &s = *g_stats;
+
+    const std::uint64_t batches = s.udp_batches.load();
+    const std::uint64_t dgrams  = s.udp_datagrams.load();
+
+    out << "[ES][STATS] udp batches=" << batches
+        << " datagrams=" << dgrams
+        << " full=" << s.udp_batch_full.load();
+    if (batches > 0) {
+        const std::ios::fmtflags flags = out.flags();
+        out << " avg=" << std::fixed << std::setprecision(2)
+            << static_cast<double>(dgrams) / static_cast<double>(batches);
+        out.flags(flags);
+    }
+    out << "\n[ES][STATS] udp batch occupancy:";
+    for (std::size_t b = 0; b < ServerStats::BATCH_BUCKETS; ++b) {
+        const std::size_t lo = (b == 0) ? 1 : (std::size_t{1} << (b - 1)) + 1;
+        const std::size_t hi = std::size_t{1} << b;
+        out << " ";
+        if (b + 1 == ServerStats::BATCH_BUCKETS) out << lo << "+";
+        else if (lo == hi) out << lo;
+        else out << lo << "-" << hi;
+        out << "=" << s.udp_batch_hist[b].load();
+    }
+    out << "\n";
+
+    const std::uint64_t hits   = s.catalog_hits.load();
+    const std::uint64_t misses = s.catalog_misses.load();
+    out << "[ES][STATS] catalog hits=" << hits << " misses=" << misses;
+    if (hits + misses > 0) {
+        const std::ios::fmtflags flags = out.flags();
+        out << " hit_ratio=" << std::fixed << std::setprecision(3)
+            << static_cast<double>(hits) / static_cast<double>(hits + misses);
+        out.flags(flags);
+    }
+    out << "\n";
+
+    const std::uint64_t dhits   = s.desc_hits.load();
+    const std::uint64_t dmisses = s.desc_misses.load();
+    out << "[ES][STATS] desc cache hits=" << dhits << " misses=" << dmisses
+        << " bytes_served=" << s.desc_bytes.load();
+    if (dhits + dmisses > 0) {
+        const std::ios::fmtflags flags = out.flags();
+        out << " hit_ratio=" << std::fixed << std::setprecision(3)
+            << static_cast<double>(dhits) / static_cast<double>(dhits + dmisses);
+        out.flags(flags);
+    }
+    out << "\n";
+
+    out << "[ES][STATS] list cache hits=" << s.list_hits.load()
+        << " misses=" << s.list_misses.load() << "\n";
+
+    // só os comandos que já tiveram pedidos
+    const std::ios::fmtflags flags = out.flags();
+    for (std::size_t c = 0; c < CMD_COUNT; ++c) {
+        const std::uint64_t n = s.cmd_requests[c].load();
+        if (n == 0) continue;
+        out << "[ES][STATS] cmd " << COMMANDS[c].tag
+            << " requests=" << n
+            << " avg_us=" << std::fixed << std::setprecision(1)
+            << static_cast<double>(s.cmd_ns[c].load()) / static_cast<double>(n) / 1000.0
+            << " max_us=" << static_cast<double>(s.cmd_max_ns[c].load()) / 1000.0
+            << "\n";
+    }
+    out.flags(flags);
+}
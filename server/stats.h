@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "commands.h"
+
+// Contadores do servidor. Vivem em memória partilhada (mmap anónimo
+// MAP_SHARED criado antes de qualquer fork), por isso os filhos dos modos
+// fork/prefork contam para o mesmo sítio que o processo pai.
+struct ServerStats {
+    // UDP em batch (recvmmsg/sendmmsg)
+    // ocupação por batch em buckets log2: [0]=1, [1]=2, [2]=3-4, [3]=5-8, ...
+    static constexpr std::size_t BATCH_BUCKETS = 10;
+
+    std::atomic<std::uint64_t> udp_batches{0};     // recvmmsg com >= 1 datagrama
+    std::atomic<std::uint64_t> udp_datagrams{0};   // datagramas recebidos em batch
+    std::atomic<std::uint64_t> udp_batch_full{0};  // batches que encheram
+    std::atomic<std::uint64_t> udp_batch_hist[BATCH_BUCKETS]{};
+
+    // catálogo de eventos em memória
+    std::atomic<std::uint64_t> catalog_hits{0};     // servido da memória
+    std::atomic<std::uint64_t> catalog_misses{0};   // lido do disco (novo/alterado)
+
+    // cache de descrições do SED
+    std::atomic<std::uint64_t> desc_hits{0};
+    std::atomic<std::uint64_t> desc_misses{0};      // lido do disco para a cache
+    std::atomic<std::uint64_t> desc_bytes{0};       // Fdata servido da cache
+
+    // RLS serializado do LST
+    std::atomic<std::uint64_t> list_hits{0};
+    std::atomic<std::uint64_t> list_misses{0};      // reconstruído
+
+    // por comando (índice CmdId): pedidos e tempo no handler
+    std::atomic<std::uint64_t> cmd_requests[CMD_COUNT]{};
+    std::atomic<std::uint64_t> cmd_ns[CMD_COUNT]{};
+    std::atomic<std::uint64_t> cmd_max_ns[CMD_COUNT]{};
+};
+
+// Cria a zona partilhada; chamar no arranque, antes de fork/threads.
+void stats_init();
+
+ServerStats &stats();
+
+// Regista um batch UDP com n datagramas (capacidade cap).
+void stats_udp_batch(std::size_t n, std::size_t cap);
+
+// Regista um acesso ao catálogo de eventos.
+void stats_catalog(bool hit);
+
+// Regista um SED com a cache de descrições ligada (bytes: Fsize num hit).
+void stats_desc_cache(bool hit, std::size_t bytes);
+
+// Regista um LST servido do RLS em cache (hit) ou reconstruído.
+void stats_list_cache(bool hit);
+
+// Regista um pedido do comando id que demorou ns nanossegundos.
+void stats_command(CmdId id, std::uint64_t ns);
+
+// Relógio monotónico em ns, para medir os handlers.
+std::uint64_t stats_clock_ns();
+
+// Escreve todos os contadores em formato legível.
+void stats_dump(std::ostream &out);
@@ -1,8 +1,11 @@
 // server/tcp.cpp
 #include "tcp.h"
 #include "tcp_handler.h"
+#include "catalog.h"
+#include "workers.h"
 
 #include <iostream>
+#include <cerrno>
 #include <cstring>
 #include <netdb.h>
 #include <unistd.h>
@@ -56,23 +59,42 @@ int tcp_create_listen_socket(std::uint16_t port)
     return fd;
 }
 
-void tcp_accept_and_fork(int listen_fd, int udp_fd, bool verbose)
+int tcp_accept_client(int listen_fd, bool verbose,
+                      char *ip_out, std::size_t ip_len, std::uint16_t &port_out)
 {
     struct sockaddr_in cli{};
     socklen_t len = sizeof(cli);
 
     int cfd = ::accept(listen_fd, (struct sockaddr*)&cli, &len);
     if (cfd < 0) {
-        std::perror("accept");
-        return;
+        if (errno != EINTR) std::perror("accept");
+        return -1;
     }
 
+    ::inet_ntop(AF_INET, &cli.sin_addr, ip_out, static_cast<socklen_t>(ip_len));
+    port_out = ntohs(cli.sin_port);
+
     if (verbose) {
         std::cout << "[ES][TCP] Accepted connection from "
-                  << ::inet_ntoa(cli.sin_addr)
-                  << ":" << ntohs(cli.sin_port)
+                  << ip_out
+                  << ":" << port_out
                   << " (fd=" << cfd << ")\n";
     }
+    return cfd;
+}
+
+void tcp_accept_and_fork(int listen_fd, int udp_fd, bool verbose)
+{
+    char ip[INET_ADDRSTRLEN];
+    std::uint16_t port = 0;
+
+    int cfd = tcp_accept_client(listen_fd, verbose, ip, sizeof(ip), port);
+    if (cfd < 0) {
+        return;
+    }
+
+    // o filho herda o catálogo: actualizá-lo antes do fork
+    catalog_refresh();
 
     pid_t pid = ::fork();
     if (pid < 0) {
@@ -84,10 +106,8 @@ void tcp_accept_and_fork(int listen_fd, int udp_fd, bool verbose)
     if (pid == 0) {
         // FILHO
         ::close(listen_fd);
-        ::close(udp_fd);
-
-        const char *ip = ::inet_ntoa(cli.sin_addr);
-        uint16_t port  = ntohs(cli.sin_port);
+        if (udp_fd >= 0) ::close(udp_fd);
+        udp_shards_close();
 
         tcp_handle_connection(cfd, verbose, ip, port); //trata um comando 
 
@@ -1,6 +1,12 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
 int tcp_create_listen_socket(std::uint16_t port);
 
+// accept() + log verbose. Preenche ip/porto do cliente.
+// Devolve o fd da ligação ou -1 em erro.
+int tcp_accept_client(int listen_fd, bool verbose,
+                      char *ip_out, std::size_t ip_len, std::uint16_t &port_out);
+
 void tcp_accept_and_fork(int listen_fd, int udp_fd, bool verbose);
@@ -4,56 +4,100 @@
 #include "events.h"
 #include "reservations.h"
 #include "protocol.h"
-
+#include "io_backend.h"
+#include "catalog.h"
+#include "expiry.h"
+#include "desc_cache.h"
+#include "stats.h"
+#include "commands.h"
+#include "datetime.h"
+
+#include <algorithm>
 #include <iostream>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <cerrno>
 #include <cstring>
-#include <sstream>
-#include <fstream>
 #include <ctime>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
 
 
-// helpers read/write exact
-static bool read_exact_fd(int fd, void *buf, std::size_t n) {
-    std::size_t done = 0;
-    char *p = static_cast<char*>(buf);
-    while (done < n) {
-        ssize_t r = ::read(fd, p + done, n - done);
-        if (r <= 0) return false;
-        done += static_cast<std::size_t>(r);
-    }
-    return true;
-}
-
-static bool write_exact_fd(int fd, const void *buf, std::size_t n) {
-    std::size_t done = 0;
-    const char *p = static_cast<const char*>(buf);
-    while (done < n) {
-        ssize_t r = ::write(fd, p + done, n - done);
-        if (r <= 0) return false;
-        done += static_cast<std::size_t>(r);
-    }
-    return true;
-}
-
-
-// Reader com 1-byte pushback 
+// Reader com 1-byte pushback.
+// Lê de um pedido já em memória (modo epoll) ou do socket (restantes
+// modos); no socket tudo passa por um buffer de entrada de 16 KiB,
+// e o Fdata segue em blocos desse tamanho para o ficheiro de destino.
 struct Reader {
+    static const std::size_t IN_BUF_SIZE = 16 * 1024;
+
     int fd;
+    int timeout_ms = -1;          // por recv; no socket: TCP_IDLE_SEC
+    const char *data = nullptr;
+    std::size_t len = 0;
+    std::size_t pos = 0;
     bool has_pb = false;
     char pb = 0;
+    char inbuf[IN_BUF_SIZE];
+
+    explicit Reader(int f) : fd(f), data(inbuf) {}
+    Reader(const char *d, std::size_t n) : fd(-1), data(d), len(n) {}
 
-    explicit Reader(int f) : fd(f) {}
+    // volta a encher o buffer a partir do socket
+    bool fill() {
+        if (fd < 0) return false;
+        ssize_t r = io_recv(fd, inbuf, sizeof(inbuf), timeout_ms);
+        if (r <= 0) return false;
+        len = static_cast<std::size_t>(r);
+        pos = 0;
+        return true;
+    }
 
     bool getch(char &c) {
         if (has_pb) { c = pb; has_pb = false; return true; }
-        ssize_t r = ::read(fd, &c, 1);
-        return r == 1;
+        if (pos >= len && !fill()) return false;
+        c = data[pos++];
+        return true;
     }
 
     void ungetch(char c) { has_pb = true; pb = c; }
 
+    // copia exatamente n bytes (Fdata) para out_fd, em blocos do buffer
+    bool copy_to_fd(int out_fd, std::size_t n) {
+        if (n > 0 && has_pb) {
+            if (!write_exact(out_fd, &pb, 1)) return false;
+            has_pb = false;
+            --n;
+        }
+        while (n > 0) {
+            if (pos >= len && !fill()) return false;
+            const std::size_t chunk = std::min(n, len - pos);
+            if (!write_exact(out_fd, data + pos, chunk)) return false;
+            pos += chunk;
+            n   -= chunk;
+        }
+        return true;
+    }
+
+    // descarta exatamente n bytes (Fdata que não tem para onde ir)
+    bool skip(std::size_t n) {
+        if (n > 0 && has_pb) {
+            has_pb = false;
+            --n;
+        }
+        while (n > 0) {
+            if (pos >= len && !fill()) return false;
+            const std::size_t chunk = std::min(n, len - pos);
+            pos += chunk;
+            n   -= chunk;
+        }
+        return true;
+    }
+
     // lê token até ' ' ou '\n'
     bool read_token(std::string &tok) {
         tok.clear();
@@ -102,40 +146,219 @@ static void tcp_verbose(bool verbose,
 }
 
 
+// RLS já serializado, reutilizado enquanto events_version não mudar e
+// nenhum evento listado como futuro tiver passado a hora (valid_until).
+// Um por processo, como o catálogo de onde vem.
+struct ListCache {
+    std::mutex    mu;
+    bool          valid = false;
+    std::uint64_t version = 0;
+    std::time_t   valid_until = 0;
+    std::shared_ptr<const std::string> reply;
+};
+
+static ListCache g_list_cache;
+
+// " EID name state dd-mm-yyyy hh:mm" (RLS e RLX)
+static void put_list_entry(std::string &reply, const EventInfo &ev)
+{
+    reply += ' ';
+    reply += ev.eid;
+    reply += ' ';
+    reply += ev.name;
+    reply += ' ';
+    reply_put_int(reply, static_cast<int>(ev.state));
+    reply += ' ';
+    reply += ev.event_date; // "dd-mm-yyyy hh:mm" -> vira 2 tokens
+}
+
+// "RLS OK EID name state dd-mm-yyyy hh:mm ...\n"; valid_until = primeiro
+// instante em que algum estado muda só por tempo
+static std::string build_list_reply(std::time_t &valid_until)
+{
+    auto events = load_all_events();
+    valid_until = std::numeric_limits<std::time_t>::max();
+    if (events.empty()) return "RLS NOK\n";
+
+    std::string reply;
+    reply.reserve(8 + events.size() * 36);
+    reply = "RLS OK";
+    for (const auto &ev : events) {
+        put_list_entry(reply, ev);
+
+        // Open/SoldOut passam a Past quando a hora actual passar event_ts
+        if (ev.state == EventState::Open || ev.state == EventState::SoldOut) {
+            valid_until = std::min(valid_until, ev.event_ts);
+        }
+    }
+    reply += '\n';
+    return reply;
+}
+
 // Handlers
-static void handle_LST(int fd, Reader &rd, bool verbose, const char *ip, uint16_t port) {
+static bool handle_LST(Reader &rd, TcpReply &out, bool verbose, const char *ip, uint16_t port) {
 
     tcp_verbose(verbose, ip, port, "LST", "------");
 
     // LST\n
     if (!rd.expect_newline()) {
-        const std::string resp = "RLS ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        out.head = "RLS ERR\n";
+        return false;
     }
 
-    auto events = load_all_events();
+    std::uint64_t version = 0;
+    if (!events_version(version)) {
+        std::time_t until;
+        out.head = build_list_reply(until);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lk(g_list_cache.mu);
+    ListCache &c = g_list_cache;
+    const bool hit = c.valid && c.version == version && dt_now() <= c.valid_until;
+    if (!hit) {
+        // versão lida antes dos eventos: uma alteração entretanto só faz
+        // o próximo LST reconstruir
+        c.reply = std::make_shared<const std::string>(build_list_reply(c.valid_until));
+        c.version = version;
+        c.valid = true;
+    }
+    stats_list_cache(hit);
+    out.add_shared(c.reply);
+    return true;
+}
+
+// Estados do LSX: "-" ou dígitos 0..3 ("12" = abertos e esgotados)
+static bool parse_lsx_states(const std::string &s, unsigned &mask)
+{
+    if (s == "-") return true;
+    if (s.empty() || s.size() > 4) return false;
+    mask = 0;
+    for (char c : s) {
+        if (c < '0' || c > '3') return false;
+        mask |= 1u << (c - '0');
+    }
+    return true;
+}
+
+// Dia do LSX: "-" (sem limite) ou dd-mm-yyyy, à hora hhmm
+static bool parse_lsx_day(const std::string &s, const char *hhmm, std::time_t &out)
+{
+    if (s == "-") return true;
+    return proto_valid_date_ddmmyyyy(s) && dt_parse_event(s + " " + hhmm, out);
+}
+
+static bool handle_LSX(Reader &rd, std::string &reply, bool verbose, const char *ip, uint16_t port) {
+    // LSX states from to prefix owner count after\n
+    // ("-" = qualquer; after = último EID da página anterior, 000 no início)
+    std::string states, from, to, prefix, owner, count_s, after;
+
+    if (!rd.expect_space() || !rd.read_token(states) ||
+        !rd.expect_space() || !rd.read_token(from) ||
+        !rd.expect_space() || !rd.read_token(to) ||
+        !rd.expect_space() || !rd.read_token(prefix) ||
+        !rd.expect_space() || !rd.read_token(owner) ||
+        !rd.expect_space() || !rd.read_token(count_s) ||
+        !rd.expect_space() || !rd.read_token(after) ||
+        !rd.expect_newline()) {
+        reply = "RLX ERR\n";
+        return false;
+    }
+
+    tcp_verbose(verbose, ip, port, "LSX", proto_valid_uid(owner) ? owner : "------");
+
+    int count = 0;
+    try { count = std::stoi(count_s); } catch (...) { count = 0; }
+
+    EventFilter f;
+    if (!parse_lsx_states(states, f.states) ||
+        !parse_lsx_day(from, "00:00", f.from) ||
+        !parse_lsx_day(to, "23:59", f.to) ||
+        (prefix != "-" && !proto_valid_event_name(prefix)) ||
+        (owner != "-" && !proto_valid_uid(owner)) ||
+        count <= 0 || count > LSX_MAX_PAGE ||
+        !proto_valid_eid(after)) {
+        reply = "RLX ERR\n";
+        return false;
+    }
+    if (prefix != "-") f.prefix = prefix;
+    if (owner != "-") f.owner = owner;
+
+    bool more = false;
+    const auto events = list_events(f, after, static_cast<std::size_t>(count), more);
     if (events.empty()) {
-        const std::string resp = "RLS NOK\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RLX NOK\n";
+        return true;
+    }
+
+    // RLX OK next n [EID name state date time]*; next = 000 na última página
+    reply.reserve(16 + events.size() * 36);
+    reply = "RLX OK ";
+    reply += more ? events.back().eid : "000";
+    reply += ' ';
+    reply_put_int(reply, static_cast<long long>(events.size()));
+    for (const auto &ev : events) put_list_entry(reply, ev);
+    reply += '\n';
+    return true;
+}
+
+// Terminador depois de Fdata: \n (aceita \r\n, ou EOF logo após os bytes)
+static bool read_fdata_end(Reader &rd, std::string &reply)
+{
+    char endc = 0;
+    if (!rd.getch(endc)) {
+        // EOF logo após bytes -> aceitável
+    } else if (endc == '\n') {
+        // ok
+    } else if (endc == '\r') {
+        char lf = 0;
+        if (!rd.getch(lf) || lf != '\n') {
+            reply = "RCE ERR\n";
+            return false;
+        }
+    } else {
+        reply = "RCE ERR\n";
+        return false;
     }
+    return true;
+}
 
-    std::ostringstream out;
-    out << "RLS OK";
-    for (const auto &ev : events) {
-        out << " " << ev.eid
-            << " " << ev.name
-            << " " << static_cast<int>(ev.state)
-            << " " << ev.event_date; // "dd-mm-yyyy hh:mm" -> vira 2 tokens
+// Resto do CRE depois de Fdata estar em staged: terminador, auth e criação.
+static bool create_staged_event(Reader &rd, std::string &reply,
+                                const std::string &uid, const std::string &pass,
+                                const std::string &name, const std::string &date_part,
+                                const std::string &time_part, int attendance,
+                                const std::string &fname, const std::string &staged)
+{
+    if (!read_fdata_end(rd, reply)) return false;
+
+    // auth
+    if (!es_user_exists(uid) || !es_user_is_logged_in(uid)) {
+        reply = "RCE NLG\n";
+        return true;
+    }
+    if (!es_user_check_password(uid, pass)) {
+        reply = "RCE WRP\n";
+        return true;
     }
-    out << "\n";
 
-    const std::string resp = out.str();
-    write_exact_fd(fd, resp.data(), resp.size());
+    // criar evento
+    std::string eid;
+    bool ok = es_create_event(uid, name, date_part, time_part, attendance, fname, staged, eid);
+    if (!ok) {
+        reply = "RCE NOK\n";
+        return true;
+    }
+    expiry_schedule(eid);
+    desc_cache_invalidate(eid);
+
+    reply = "RCE OK ";
+    reply += eid;
+    reply += '\n';
+    return true;
 }
 
-static void handle_CRE(int fd, Reader &rd, bool verbose, const char *ip, uint16_t port) {
+static bool handle_CRE(Reader &rd, std::string &reply, bool verbose, const char *ip, uint16_t port) {
     // CRE UID PASS NAME dd-mm-yyyy hh:mm ATT Fname Fsize Fdata\n
 
     std::string uid, pass, name, date_part, time_part, att_s, fname, fsize_s;
@@ -148,9 +371,8 @@ static void handle_CRE(int fd, Reader &rd, bool verbose, const char *ip, uint16_
         !rd.expect_space() || !rd.read_token(att_s) ||
         !rd.expect_space() || !rd.read_token(fname) ||
         !rd.expect_space() || !rd.read_token(fsize_s)) {
-        const std::string resp = "RCE ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCE ERR\n";
+        return false;
     }
 
     // verbose por request (sem password)
@@ -162,15 +384,13 @@ static void handle_CRE(int fd, Reader &rd, bool verbose, const char *ip, uint16_
         attendance = std::stoi(att_s);
         fsize_ll = std::stoll(fsize_s);
     } catch (...) {
-        const std::string resp = "RCE ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCE ERR\n";
+        return false;
     }
 
     if (fsize_ll < 0 || fsize_ll > MAX_FILE_SIZE_BYTES) {
-        const std::string resp = "RCE ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCE ERR\n";
+        return false;
     }
     const int fsize = static_cast<int>(fsize_ll);
 
@@ -182,75 +402,48 @@ static void handle_CRE(int fd, Reader &rd, bool verbose, const char *ip, uint16_
         !proto_valid_time_hhmm(time_part) ||
         attendance < MIN_ATTENDANCE || attendance > MAX_ATTENDANCE ||
         !proto_valid_fname(fname)) {
-        const std::string resp = "RCE ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCE ERR\n";
+        return false;
     }
 
     //tem de haver UM espaço entre Fsize e os bytes
     char sep = 0;
     if (!rd.getch(sep) || sep != ' ') {
-        const std::string resp = "RCE ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
-    }
-
-    // ler Fdata
-    std::string file_data;
-    file_data.resize(static_cast<std::size_t>(fsize));
-    if (fsize > 0) {
-        if (!read_exact_fd(fd, file_data.data(), static_cast<std::size_t>(fsize))) {
-            const std::string resp = "RCE NOK\n";
-            write_exact_fd(fd, resp.data(), resp.size());
-            return;
-        }
-    }
-
-    // terminador final: \n (aceita \r\n também)
-    char endc = 0;
-    if (!rd.getch(endc)) {
-        // EOF logo após bytes -> aceitável
-    } else if (endc == '\n') {
-        // ok
-    } else if (endc == '\r') {
-        char lf = 0;
-        if (!rd.getch(lf) || lf != '\n') {
-            const std::string resp = "RCE ERR\n";
-            write_exact_fd(fd, resp.data(), resp.size());
-            return;
+        reply = "RCE ERR\n";
+        return false;
+    }
+
+    // Fdata vai por blocos para um ficheiro de staging; só passa para
+    // DESCRIPTION (rename) se o evento for mesmo criado
+    std::string staged;
+    int sfd = es_open_staging_file(staged);
+    if (sfd < 0) {
+        // Fdata tem de sair do socket na mesma, senão com KAL os bytes
+        // seriam lidos como o pedido seguinte
+        if (!rd.skip(static_cast<std::size_t>(fsize)) || !read_fdata_end(rd, reply)) {
+            reply = "RCE NOK\n";
+            return false;
         }
-    } else {
-        const std::string resp = "RCE ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCE NOK\n";
+        return true;
     }
 
-    // auth
-    if (!es_user_exists(uid) || !es_user_is_logged_in(uid)) {
-        const std::string resp = "RCE NLG\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
-    }
-    if (!es_user_check_password(uid, pass)) {
-        const std::string resp = "RCE WRP\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+    const bool got_data = rd.copy_to_fd(sfd, static_cast<std::size_t>(fsize));
+    ::close(sfd);
+    if (!got_data) {
+        // não se sabe quantos bytes de Fdata ficaram por ler: fecha
+        ::unlink(staged.c_str());
+        reply = "RCE NOK\n";
+        return false;
     }
 
-    // criar evento
-    std::string eid;
-    bool ok = es_create_event(uid, name, date_part, time_part, attendance, fname, file_data, eid);
-    if (!ok) {
-        const std::string resp = "RCE NOK\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
-    }
-
-    const std::string resp = "RCE OK " + eid + "\n";
-    write_exact_fd(fd, resp.data(), resp.size());
+    const bool ok = create_staged_event(rd, reply, uid, pass, name, date_part, time_part,
+                                        attendance, fname, staged);
+    ::unlink(staged.c_str());   // no-op se já foi movido
+    return ok;
 }
 
-static void handle_RID(int fd, Reader &rd, bool verbose, const char *ip, uint16_t port) {
+static bool handle_RID(Reader &rd, std::string &reply, bool verbose, const char *ip, uint16_t port) {
     // RID UID PASS EID people\n
     std::string uid, pass, eid, ppl_s;
 
@@ -259,9 +452,8 @@ static void handle_RID(int fd, Reader &rd, bool verbose, const char *ip, uint16_
         !rd.expect_space() || !rd.read_token(eid) ||
         !rd.expect_space() || !rd.read_token(ppl_s) ||
         !rd.expect_newline()) {
-        const std::string resp = "RRI ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RRI ERR\n";
+        return false;
     }
 
     tcp_verbose(verbose, ip, port, "RID", proto_valid_uid(uid) ? uid : "------");
@@ -272,29 +464,31 @@ static void handle_RID(int fd, Reader &rd, bool verbose, const char *ip, uint16_
 
     if (!proto_valid_uid(uid) || !proto_valid_password(pass) || !proto_valid_eid(eid) ||
         people <= 0 || people > MAX_RESERVE_PEOPLE) {
-        const std::string resp = "RRI ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RRI ERR\n";
+        return false;
     }
 
     int remaining = 0;
     ReserveStatus st = es_make_reservation(uid, pass, eid, people, remaining);
 
-    std::string resp;
     switch (st) {
-        case ReserveStatus::ACC: resp = "RRI ACC\n"; break;
-        case ReserveStatus::REJ: resp = "RRI REJ " + std::to_string(remaining) + "\n"; break;
-        case ReserveStatus::CLS: resp = "RRI CLS\n"; break;
-        case ReserveStatus::SLD: resp = "RRI SLD\n"; break;
-        case ReserveStatus::PST: resp = "RRI PST\n"; break;
-        case ReserveStatus::NLG: resp = "RRI NLG\n"; break;
-        case ReserveStatus::WRP: resp = "RRI WRP\n"; break;
-        default: resp = "RRI NOK\n"; break;
-    }
-    write_exact_fd(fd, resp.data(), resp.size());
+        case ReserveStatus::ACC: reply = "RRI ACC\n"; break;
+        case ReserveStatus::REJ:
+            reply = "RRI REJ ";
+            reply_put_int(reply, remaining);
+            reply += '\n';
+            break;
+        case ReserveStatus::CLS: reply = "RRI CLS\n"; break;
+        case ReserveStatus::SLD: reply = "RRI SLD\n"; break;
+        case ReserveStatus::PST: reply = "RRI PST\n"; break;
+        case ReserveStatus::NLG: reply = "RRI NLG\n"; break;
+        case ReserveStatus::WRP: reply = "RRI WRP\n"; break;
+        default: reply = "RRI NOK\n"; break;
+    }
+    return true;
 }
 
-static void handle_CLS(int fd, Reader &rd, bool verbose, const char *ip, uint16_t port) {
+static bool handle_CLS(Reader &rd, std::string &reply, bool verbose, const char *ip, uint16_t port) {
     // CLS UID PASS EID\n
     std::string uid, pass, eid;
 
@@ -302,61 +496,52 @@ static void handle_CLS(int fd, Reader &rd, bool verbose, const char *ip, uint16_
         !rd.expect_space() || !rd.read_token(pass) ||
         !rd.expect_space() || !rd.read_token(eid) ||
         !rd.expect_newline()) {
-        const std::string resp = "RCL ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCL ERR\n";
+        return false;
     }
 
     tcp_verbose(verbose, ip, port, "CLS", proto_valid_uid(uid) ? uid : "------");
 
 
     if (!proto_valid_uid(uid) || !proto_valid_password(pass) || !proto_valid_eid(eid)) {
-        const std::string resp = "RCL ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCL ERR\n";
+        return false;
     }
 
     if (!es_user_exists(uid) || !es_user_check_password(uid, pass)) {
-        const std::string resp = "RCL NOK\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCL NOK\n";
+        return true;
     }
 
     if (!es_user_is_logged_in(uid)) {
-        const std::string resp = "RCL NLG\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCL NLG\n";
+        return true;
     }
 
     EventInfo ev;
     if (!load_event(eid, ev)) {
-        const std::string resp = "RCL NOE\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCL NOE\n";
+        return true;
     }
 
     if (ev.owner_uid != uid) {
-        const std::string resp = "RCL EOW\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCL EOW\n";
+        return true;
     }
 
     switch (ev.state) {
         case EventState::SoldOut: {
-            const std::string resp = "RCL SLD\n";
-            write_exact_fd(fd, resp.data(), resp.size());
-            return;
+            reply = "RCL SLD\n";
+            return true;
         }
         case EventState::Past: {
-            (void)ensure_end_if_past(eid, ev.event_date);
-            const std::string resp = "RCL PST\n";
-            write_exact_fd(fd, resp.data(), resp.size());
-            return;
+            // o END automático fica para o agendador (expiry.h)
+            reply = "RCL PST\n";
+            return true;
         }
         case EventState::ClosedByUser: {
-            const std::string resp = "RCL CLO\n";
-            write_exact_fd(fd, resp.data(), resp.size());
-            return;
+            reply = "RCL CLO\n";
+            return true;
         }
         case EventState::Open:
         default:
@@ -364,105 +549,104 @@ static void handle_CLS(int fd, Reader &rd, bool verbose, const char *ip, uint16_
     }
 
     // criar END
-    const std::string end_path = event_dir(eid) + "/END " + eid + ".txt";
-
-    std::time_t now = std::time(nullptr);
-    std::tm *lt = std::localtime(&now);
-    if (!lt) {
-        const std::string resp = "RCL NOK\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
-    }
-
-    char buf[32];
-    if (std::strftime(buf, sizeof(buf), "%d-%m-%Y %H:%M:%S", lt) == 0) {
-        const std::string resp = "RCL NOK\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
-    }
-
-    std::ofstream out(end_path);
-    if (!out.is_open()) {
-        const std::string resp = "RCL NOK\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
-    }
-    out << buf << "\n";
-    if (!out.good()) {
-        const std::string resp = "RCL NOK\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+    if (!es_close_event(eid)) {
+        reply = "RCL NOK\n";
+        return true;
     }
 
-    const std::string resp = "RCL OK\n";
-    write_exact_fd(fd, resp.data(), resp.size());
+    reply = "RCL OK\n";
+    return true;
 }
 
-static void handle_SED(int fd, Reader &rd, bool verbose, const char *ip, uint16_t port) {
+static bool handle_SED(Reader &rd, TcpReply &out, bool verbose, const char *ip, uint16_t port) {
 
      tcp_verbose(verbose, ip, port, "SED", "------");
 
     // SED EID\n -> RSE OK ... Fsize Fdata\n
+    std::string &reply = out.head;
     std::string eid;
 
     if (!rd.expect_space() || !rd.read_token(eid) || !rd.expect_newline()) {
-        const std::string resp = "RSE ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RSE ERR\n";
+        return false;
     }
 
     if (!proto_valid_eid(eid)) {
-        const std::string resp = "RSE ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RSE ERR\n";
+        return false;
     }
 
     EventInfo ev;
     if (!load_event(eid, ev)) {
-        const std::string resp = "RSE NOK\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
-    }
-
-    if (ev.state == EventState::Past) {
-        (void)ensure_end_if_past(eid, ev.event_date);
+        reply = "RSE NOK\n";
+        return true;
+    }
+
+    // header até Fname (inclusive), com SPACE; depois Fsize, Fdata e '\n'
+    reply = "RSE OK ";
+    reply += ev.owner_uid;
+    reply += ' ';
+    reply += ev.name;
+    reply += ' ';
+    reply += ev.event_date;
+    reply += ' ';
+    reply_put_int(reply, ev.capacity);
+    reply += ' ';
+    reply_put_int(reply, ev.reserved);
+    reply += ' ';
+    reply += ev.desc_fname;
+    reply += ' ';
+
+    // hit: Fdata entra como segmento próprio, head fica só com o cabeçalho
+    std::string cached;
+    if (desc_cache_get(eid, ev.desc_fname, cached)) {
+        stats_desc_cache(true, cached.size());
+        reply_put_int(reply, static_cast<long long>(cached.size()));
+        reply += ' ';
+        out.add_owned(std::move(cached));
+        out.add_text("\n");
+        return true;
     }
 
     const std::string desc_path = event_dir(eid) + "/DESCRIPTION/" + ev.desc_fname;
-    std::ifstream f(desc_path, std::ios::binary);
-    if (!f.is_open()) {
-        const std::string resp = "RSE NOK\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
-    }
-
-    std::string fdata((std::istreambuf_iterator<char>(f)),
-                      std::istreambuf_iterator<char>());
-    const int fsize = static_cast<int>(fdata.size());
-
-    // header termina com SPACE e depois vem Fdata e no fim '\n'
-    std::ostringstream hdr;
-    hdr << "RSE OK "
-        << ev.owner_uid << " "
-        << ev.name << " "
-        << ev.event_date << " "
-        << ev.capacity << " "
-        << ev.reserved << " "
-        << ev.desc_fname << " "
-        << fsize << " ";
-
-    const std::string header = hdr.str();
-    if (!write_exact_fd(fd, header.data(), header.size())) return;
-
-    if (fsize > 0) {
-        if (!write_exact_fd(fd, fdata.data(), static_cast<std::size_t>(fsize))) return;
+    int dfd = ::open(desc_path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if (dfd < 0 || ::fstat(dfd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        if (dfd >= 0) ::close(dfd);
+        reply = "RSE NOK\n";
+        return true;
+    }
+    const std::size_t fsize = static_cast<std::size_t>(st.st_size);
+    reply_put_int(reply, static_cast<long long>(fsize));
+    reply += ' ';
+
+    // cabe na cache e é o segundo pedido: lido uma vez para memória e
+    // servido de lá (o buffer lido passa para a resposta, sem cópia)
+    if (desc_cache_fits(fsize)) stats_desc_cache(false, 0);
+    if (desc_cache_miss(eid, ev.desc_fname, fsize)) {
+        std::string data(fsize, '\0');
+        if (fsize == 0 || read_exact(dfd, &data[0], fsize)) {
+            ::close(dfd);
+            desc_cache_put(eid, ev.desc_fname, data);
+            out.add_owned(std::move(data));
+            out.add_text("\n");
+            return true;
+        }
+        if (::lseek(dfd, 0, SEEK_SET) < 0) {
+            ::close(dfd);
+            reply = "RSE NOK\n";
+            return true;
+        }
     }
 
-    const char nl = '\n';
-    write_exact_fd(fd, &nl, 1);
+    // primeiro pedido ou grande demais: Fdata vai directamente do ficheiro
+    // para o socket (sendfile)
+    out.add_file(dfd, fsize);
+    out.add_text("\n");
+    return true;
 }
 
-static void handle_CPS(int fd, Reader &rd, bool verbose, const char *ip, uint16_t port) {
+static bool handle_CPS(Reader &rd, std::string &reply, bool verbose, const char *ip, uint16_t port) {
     // CPS UID old new\n
     std::string uid, oldp, newp;
 
@@ -470,44 +654,189 @@ static void handle_CPS(int fd, Reader &rd, bool verbose, const char *ip, uint16_
         !rd.expect_space() || !rd.read_token(oldp) ||
         !rd.expect_space() || !rd.read_token(newp) ||
         !rd.expect_newline()) {
-        const std::string resp = "RCP ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCP ERR\n";
+        return false;
     }
 
     tcp_verbose(verbose, ip, port, "CPS", proto_valid_uid(uid) ? uid : "------");
 
     if (!proto_valid_uid(uid) || !proto_valid_password(oldp) || !proto_valid_password(newp)) {
-        const std::string resp = "RCP ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
-        return;
+        reply = "RCP ERR\n";
+        return false;
     }
 
     UserStatus st = es_user_change_password(uid, oldp, newp);
-    const std::string resp = "RCP " + user_status_to_string(st) + "\n";
-    write_exact_fd(fd, resp.data(), resp.size());
+    reply = "RCP ";
+    reply += user_status_to_string(st);
+    reply += '\n';
+    return true;
 }
 
 
-void tcp_handle_connection(int fd, bool verbose, const char *ip, uint16_t port)
+// prefork/threads desligam (tcp_set_keepalive_allowed)
+static bool g_keepalive_allowed = true;
+
+void tcp_set_keepalive_allowed(bool allowed)
 {
-    Reader rd(fd);
+    g_keepalive_allowed = allowed;
+}
+
+// KAL\n -> RKA OK\n: a partir daqui a ligação serve vários comandos
+static bool handle_KAL(Reader &rd, std::string &reply, bool &keep_alive,
+                       bool verbose, const char *ip, uint16_t port) {
+    tcp_verbose(verbose, ip, port, "KAL", "------");
+
+    if (!rd.expect_newline()) {
+        reply = "RKA ERR\n";
+        return false;
+    }
+    if (!g_keepalive_allowed) {
+        reply = "RKA NOK\n";
+        return true;
+    }
+    keep_alive = true;
+    reply = "RKA OK\n";
+    return true;
+}
+
+
+// Um pedido TCP em curso: o que os handlers podem precisar
+struct TcpRequest {
+    Reader     &rd;
+    TcpReply   &out;
+    bool       &keep_alive;
+    bool        verbose;
+    const char *ip;
+    uint16_t    port;
+};
+
+// false: pedido mal formado (resposta ERR)
+using TcpHandler = bool (*)(TcpRequest &);
+
+struct TcpHandlers {
+    TcpHandler h[CMD_COUNT];
+};
+
+static constexpr TcpHandlers tcp_handlers()
+{
+    TcpHandlers t{};
+    t.h[cmd_index(CmdId::LST)] = [](TcpRequest &r) { return handle_LST(r.rd, r.out, r.verbose, r.ip, r.port); };
+    t.h[cmd_index(CmdId::CRE)] = [](TcpRequest &r) { return handle_CRE(r.rd, r.out.head, r.verbose, r.ip, r.port); };
+    t.h[cmd_index(CmdId::RID)] = [](TcpRequest &r) { return handle_RID(r.rd, r.out.head, r.verbose, r.ip, r.port); };
+    t.h[cmd_index(CmdId::CLS)] = [](TcpRequest &r) { return handle_CLS(r.rd, r.out.head, r.verbose, r.ip, r.port); };
+    t.h[cmd_index(CmdId::SED)] = [](TcpRequest &r) { return handle_SED(r.rd, r.out, r.verbose, r.ip, r.port); };
+    t.h[cmd_index(CmdId::CPS)] = [](TcpRequest &r) { return handle_CPS(r.rd, r.out.head, r.verbose, r.ip, r.port); };
+    t.h[cmd_index(CmdId::KAL)] = [](TcpRequest &r) {
+        return handle_KAL(r.rd, r.out.head, r.keep_alive, r.verbose, r.ip, r.port);
+    };
+    t.h[cmd_index(CmdId::LSX)] = [](TcpRequest &r) { return handle_LSX(r.rd, r.out.head, r.verbose, r.ip, r.port); };
+    return t;
+}
 
+static constexpr TcpHandlers TCP_HANDLERS = tcp_handlers();
+static_assert(cmd_handlers_cover(TCP_HANDLERS.h, Transport::Tcp),
+              "comando TCP sem handler (commands.h)");
+
+
+// Lê a tag e despacha para o handler; devolve false se nem a tag chegou.
+// Depois de um pedido mal formado (resposta ERR) o resto do stream não é
+// fiável: keep_alive passa a false e a ligação fecha. Quem o diz é o
+// handler, não o texto da resposta (Fdata de um SED pode acabar em "ERR").
+static bool dispatch_request(Reader &rd, TcpReply &out, bool &keep_alive,
+                             bool verbose, const char *ip, uint16_t port)
+{
     std::string tag;
-    if (!rd.read_token(tag)) { ::close(fd); return; }
-
-    if (tag == "LST") handle_LST(fd, rd, verbose, ip, port);
-    else if (tag == "CRE") handle_CRE(fd, rd, verbose, ip, port);
-    else if (tag == "RID") handle_RID(fd, rd, verbose, ip, port);
-    else if (tag == "CLS") handle_CLS(fd, rd, verbose, ip, port);
-    else if (tag == "SED") handle_SED(fd, rd, verbose, ip, port);
-    else if (tag == "CPS") handle_CPS(fd, rd, verbose, ip, port);
-    else {
+    if (!rd.read_token(tag)) return false;
+
+    bool well_formed = false;
+    const CommandInfo *c = cmd_lookup(tag);
+    if (c && c->transport == Transport::Tcp) {
+        TcpRequest req{rd, out, keep_alive, verbose, ip, port};
+        const std::uint64_t t0 = stats_clock_ns();
+        well_formed = TCP_HANDLERS.h[cmd_index(c->id)](req);
+        stats_command(c->id, stats_clock_ns() - t0);
+    } else {
         if (verbose) tcp_verbose(verbose, ip, port, tag.c_str(), "------");
-        const std::string resp = "ERR\n";
-        write_exact_fd(fd, resp.data(), resp.size());
+        out.head = "ERR\n";
     }
 
+    if (!well_formed) keep_alive = false;
+    return true;
+}
+
+void tcp_handle_connection(int fd, bool verbose, const char *ip, uint16_t port)
+{
+    Reader rd(fd);
+    bool keep_alive = false;
+
+    // no backend (poll ou LINK_TIMEOUT): SO_RCVTIMEO não chega ao io_uring.
+    // Um recv que expira conta como EOF: o pedido falha e a ligação fecha.
+    rd.timeout_ms = TCP_IDLE_SEC * 1000;
+
+    // sem KAL: um só comando (comportamento de sempre)
+    do {
+        TcpReply reply;
+        const bool was_keep_alive = keep_alive;
+
+        if (!dispatch_request(rd, reply, keep_alive, verbose, ip, port)) break;
+        if (reply.empty() || !tcp_reply_send_all(fd, reply)) break;
+
+        if (keep_alive && !was_keep_alive) {
+            catalog_adopt();   // filho do modo fork que passa a viver mais
+        }
+    } while (keep_alive);
+
     ::close(fd);
 }
 
+void tcp_handle_request(const char *data, std::size_t len, bool verbose,
+                        const char *ip, uint16_t port, TcpReply &reply,
+                        bool &keep_alive)
+{
+    Reader rd(data, len);
+    reply.reset();
+    dispatch_request(rd, reply, keep_alive, verbose, ip, port);
+}
+
+// Framing: um pedido termina no primeiro '\n', excepto CRE, cujo header
+// traz Fsize e é seguido de Fdata + terminador ('\n' ou "\r\n").
+// Pedidos mal formados terminam onde o handler vai dar ERR.
+std::size_t tcp_request_frame_length(const char *data, std::size_t len)
+{
+    const char *nl = static_cast<const char*>(std::memchr(data, '\n', len));
+    const std::size_t line_len = nl ? static_cast<std::size_t>(nl - data) + 1 : 0;
+
+    // tag
+    std::size_t i = 0;
+    while (i < len && data[i] == ' ') ++i;
+    const std::size_t tag_start = i;
+    while (i < len && data[i] != ' ' && data[i] != '\n') ++i;
+    if (i == len) return 0;
+
+    const CommandInfo *c = cmd_lookup(std::string_view(data + tag_start, i - tag_start));
+    if (!c || c->id != CmdId::CRE) {
+        return line_len;
+    }
+
+    // CRE UID PASS NAME date time ATT Fname Fsize<SP>
+    std::string tok;
+    for (int field = 0; field < 8; ++field) {
+        if (data[i] != ' ') return i + 1;          // ERR no separador
+        ++i;
+        while (i < len && data[i] == ' ') ++i;
+        const std::size_t start = i;
+        while (i < len && data[i] != ' ' && data[i] != '\n') ++i;
+        if (i == len) return 0;
+        tok.assign(data + start, i - start);
+    }
+    if (data[i] != ' ') return i + 1;
+
+    long long fsize = -1;
+    try { fsize = std::stoll(tok); } catch (...) { fsize = -1; }
+    if (fsize < 0 || fsize > MAX_FILE_SIZE_BYTES) return i + 1;
+
+    const std::size_t end = i + 1 + static_cast<std::size_t>(fsize);
+    if (len <= end) return 0;
+    if (data[end] != '\r') return end + 1;
+    return (len > end + 1) ? end + 2 : 0;
+}
@@ -1,5 +1,36 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
+#include <string>
 
-// Trata UMA ligação TCP (UM comando)
+#include "tcp_reply.h"
+
+// Keep-alive (opt-in): o cliente abre com "KAL\n" e recebe "RKA OK\n";
+// daí em diante a ligação serve comandos em sequência (podem vir vários
+// seguidos, as respostas saem pela mesma ordem) até EOF, uma resposta
+// ERR ou TCP_IDLE_SEC sem pedidos. Sem KAL: um comando e fecha.
+//
+// TCP_IDLE_SEC vale para qualquer ligação, com ou sem KAL: um cliente
+// que fica TCP_IDLE_SEC sem enviar nada é fechado, para não prender um
+// worker (prefork/threads) nem um slot do reactor.
+constexpr int TCP_IDLE_SEC = 30;
+
+// Com allowed = false o KAL responde "RKA NOK\n" e a ligação fecha, como
+// depois de qualquer comando sem KAL. Para prefork/threads: aí uma
+// ligação KAL parada prende um worker até TCP_IDLE_SEC, e -w clientes
+// KAL calados deixavam todos os outros à espera. fork e epoll aceitam
+// KAL (por omissão).
+void tcp_set_keepalive_allowed(bool allowed);
+
+// Trata UMA ligação TCP (UM comando, ou vários com KAL)
 void tcp_handle_connection(int fd, bool verbose, const char *ip, uint16_t port);
+
+// Trata UM pedido que já está todo em memória (modo epoll).
+// A resposta fica em reply (head vazio se nem a tag foi lida).
+// keep_alive: estado KAL da ligação (KAL liga, resposta ERR desliga).
+void tcp_handle_request(const char *data, std::size_t len, bool verbose,
+                        const char *ip, uint16_t port, TcpReply &reply,
+                        bool &keep_alive);
+
+// Nº de bytes do primeiro pedido completo em data, ou 0 se ainda faltam bytes.
+std::size_t tcp_request_frame_length(const char *data, std::size_t len);
@@ -0,0 +1,203 @@
+// server/tcp_reply.cpp
+#include "tcp_reply.h"
+#include "io_backend.h"
+
+#include <cerrno>
+#include <charconv>
+
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// iovecs por sendmsg (head + segmentos de memória até ao próximo ficheiro)
+static const std::size_t REPLY_MAX_IOV = 16;
+
+TcpReply::~TcpReply()
+{
+    reset();
+}
+
+void TcpReply::reset()
+{
+    for (Seg &s : segs) {
+        if (s.kind == SegKind::File && s.fd >= 0) ::close(s.fd);
+    }
+    segs.clear();
+    head.clear();
+    cur_seg = 0;
+    cur_off = 0;
+}
+
+void TcpReply::add_text(std::string_view s)
+{
+    if (segs.empty() || segs.back().kind != SegKind::Text) {
+        segs.push_back(Seg{SegKind::Text, {}, {}, 0, -1});
+    }
+    segs.back().own.append(s.data(), s.size());
+}
+
+void TcpReply::add_owned(std::string &&s)
+{
+    segs.push_back(Seg{SegKind::Owned, std::move(s), {}, 0, -1});
+}
+
+void TcpReply::add_shared(std::shared_ptr<const std::string> s)
+{
+    segs.push_back(Seg{SegKind::Shared, {}, std::move(s), 0, -1});
+}
+
+void TcpReply::add_file(int fd, std::size_t len)
+{
+    segs.push_back(Seg{SegKind::File, {}, {}, len, fd});
+}
+
+// Bytes do segmento i (0 = head); nullptr para ficheiros
+static const char *seg_data(const TcpReply &r, std::size_t i, std::size_t &len)
+{
+    if (i == 0) {
+        len = r.head.size();
+        return r.head.data();
+    }
+    const TcpReply::Seg &s = r.segs[i - 1];
+    switch (s.kind) {
+    case TcpReply::SegKind::Text:
+    case TcpReply::SegKind::Owned:
+        len = s.own.size();
+        return s.own.data();
+    case TcpReply::SegKind::Shared:
+        len = s.shared ? s.shared->size() : 0;
+        return s.shared ? s.shared->data() : nullptr;
+    case TcpReply::SegKind::File:
+        break;
+    }
+    len = s.len;
+    return nullptr;
+}
+
+static std::size_t seg_count(const TcpReply &r)
+{
+    return r.segs.size() + 1;
+}
+
+static bool seg_is_file(const TcpReply &r, std::size_t i)
+{
+    return i > 0 && r.segs[i - 1].kind == TcpReply::SegKind::File;
+}
+
+// iovecs desde o cursor até ao próximo ficheiro (ou ao fim).
+// more = há mais segmentos depois destes.
+static std::size_t gather(const TcpReply &r, struct iovec *iov, bool &more)
+{
+    std::size_t n = 0;
+    std::size_t i = r.cur_seg;
+    std::size_t off = r.cur_off;
+
+    for (; i < seg_count(r) && !seg_is_file(r, i) && n < REPLY_MAX_IOV; ++i, off = 0) {
+        std::size_t len = 0;
+        const char *p = seg_data(r, i, len);
+        if (len <= off) continue;
+        iov[n].iov_base = const_cast<char*>(p + off);
+        iov[n].iov_len  = len - off;
+        ++n;
+    }
+    more = i < seg_count(r);
+    return n;
+}
+
+// Avança o cursor done bytes (segmentos de memória)
+static void advance(TcpReply &r, std::size_t done)
+{
+    while (r.cur_seg < seg_count(r) && !seg_is_file(r, r.cur_seg)) {
+        std::size_t len = 0;
+        seg_data(r, r.cur_seg, len);
+        const std::size_t left = len - r.cur_off;
+        if (done < left) {
+            r.cur_off += done;
+            return;
+        }
+        done -= left;
+        ++r.cur_seg;
+        r.cur_off = 0;
+    }
+}
+
+void reply_put_int(std::string &s, long long v)
+{
+    char buf[24];
+    const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    s.append(buf, r.ptr);
+}
+
+bool tcp_reply_send_all(int fd, TcpReply &r)
+{
+    struct iovec iov[REPLY_MAX_IOV];
+
+    while (r.cur_seg < seg_count(r)) {
+        if (seg_is_file(r, r.cur_seg)) {
+            const TcpReply::Seg &s = r.segs[r.cur_seg - 1];
+            off_t off = static_cast<off_t>(r.cur_off);
+            while (static_cast<std::size_t>(off) < s.len) {
+                ssize_t w = ::sendfile(fd, s.fd, &off, s.len - static_cast<std::size_t>(off));
+                if (w < 0 && errno == EINTR) continue;
+                if (w <= 0) return false;
+            }
+            ++r.cur_seg;
+            r.cur_off = 0;
+            continue;
+        }
+
+        bool more = false;
+        const std::size_t n = gather(r, iov, more);
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < n; ++i) total += iov[i].iov_len;
+
+        if (n > 0 && !io_sendmsg_all(fd, iov, n, more ? MSG_MORE : 0)) return false;
+        advance(r, total);
+    }
+    return true;
+}
+
+int tcp_reply_send_some(int fd, TcpReply &r)
+{
+    struct iovec iov[REPLY_MAX_IOV];
+
+    while (r.cur_seg < seg_count(r)) {
+        if (seg_is_file(r, r.cur_seg)) {
+            const TcpReply::Seg &s = r.segs[r.cur_seg - 1];
+            off_t off = static_cast<off_t>(r.cur_off);
+            while (static_cast<std::size_t>(off) < s.len) {
+                ssize_t w = ::sendfile(fd, s.fd, &off, s.len - static_cast<std::size_t>(off));
+                if (w < 0) {
+                    if (errno == EINTR) continue;
+                    r.cur_off = static_cast<std::size_t>(off);
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+                    return -1;
+                }
+                if (w == 0) return -1;   // ficheiro encolheu
+            }
+            ++r.cur_seg;
+            r.cur_off = 0;
+            continue;
+        }
+
+        bool more = false;
+        const std::size_t n = gather(r, iov, more);
+        if (n == 0) {
+            advance(r, 0);
+            continue;
+        }
+
+        struct msghdr msg{};
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = n;
+        ssize_t w = ::sendmsg(fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -1;
+        }
+        advance(r, static_cast<std::size_t>(w));
+    }
+    return 1;
+}
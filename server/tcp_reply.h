@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Resposta TCP como lista de segmentos, enviada com sendmsg (iovec):
+// o texto em head, seguido de fragmentos pequenos e de payloads grandes,
+// cada um no seu segmento em vez de copiados para head. Um segmento
+// de ficheiro vai por sendfile; os segmentos antes dele saem com
+// MSG_MORE para o TCP juntar tudo em segmentos cheios.
+//
+// Os handlers simples só escrevem head (uma resposta = um sendmsg).
+struct TcpReply {
+    std::string head;
+
+    TcpReply() = default;
+    ~TcpReply();
+
+    TcpReply(const TcpReply&) = delete;
+    TcpReply &operator=(const TcpReply&) = delete;
+
+    // Fragmento pequeno, copiado (junta-se ao anterior se também for texto)
+    void add_text(std::string_view s);
+
+    // Payload que passa a ser da resposta (sem cópia)
+    void add_owned(std::string &&s);
+
+    // Payload partilhado (ex.: buffer de uma cache), mantido vivo até ao envio
+    void add_shared(std::shared_ptr<const std::string> s);
+
+    // len bytes de fd (desde o início) por sendfile; o fd fecha com a resposta
+    void add_file(int fd, std::size_t len);
+
+    // Esvazia (fecha o ficheiro, se houver) para a próxima resposta.
+    void reset();
+
+    bool empty() const { return head.empty() && segs.empty(); }
+
+    // --- envio (tcp_reply.cpp) ---
+    enum class SegKind { Text, Owned, Shared, File };
+    struct Seg {
+        SegKind     kind;
+        std::string own;                          // Text/Owned
+        std::shared_ptr<const std::string> shared;
+        std::size_t len = 0;                      // File
+        int         fd  = -1;                     // File
+    };
+    std::vector<Seg> segs;
+
+    // cursor: 0 = head, i + 1 = segs[i]
+    std::size_t cur_seg = 0;
+    std::size_t cur_off = 0;
+};
+
+// Acrescenta v em decimal a s (sem ostringstream nem to_string)
+void reply_put_int(std::string &s, long long v);
+
+// Socket bloqueante: envia a resposta toda. false em erro.
+bool tcp_reply_send_all(int fd, TcpReply &r);
+
+// Socket não bloqueante: envia o que o socket aceitar a partir do cursor.
+// 1 = resposta toda enviada, 0 = socket cheio, -1 = erro.
+int tcp_reply_send_some(int fd, TcpReply &r);
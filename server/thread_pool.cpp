@@ -0,0 +1,50 @@
+// server/thread_pool.cpp
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(std::size_t nthreads, std::size_t max_queue)
+    : max_queue_(max_queue > 0 ? max_queue : 1)
+{
+    if (nthreads == 0) nthreads = 1;
+    workers_.reserve(nthreads);
+    for (std::size_t i = 0; i < nthreads; ++i) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        stop_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+    for (auto &t : workers_) t.join();
+}
+
+void ThreadPool::submit(Job job)
+{
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        not_full_.wait(lk, [this] { return stop_ || queue_.size() < max_queue_; });
+        if (stop_) return;
+        queue_.push_back(std::move(job));
+    }
+    not_empty_.notify_one();
+}
+
+void ThreadPool::worker_loop()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            not_empty_.wait(lk, [this] { return stop_ || !queue_.empty(); });
+            if (stop_ && queue_.empty()) return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        not_full_.notify_one();
+        job();
+    }
+}
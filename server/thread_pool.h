@@ -0,0 +1,36 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool fixo de threads com fila de trabalho limitada.
+// submit() bloqueia enquanto a fila estiver cheia, o que trava quem
+// aceita ligações em vez de deixar a fila crescer sem limite.
+class ThreadPool {
+public:
+    using Job = std::function<void()>;
+
+    ThreadPool(std::size_t nthreads, std::size_t max_queue);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool &operator=(const ThreadPool&) = delete;
+
+    void submit(Job job);
+
+private:
+    void worker_loop();
+
+    std::mutex              mtx_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<Job>         queue_;
+    std::size_t             max_queue_;
+    bool                    stop_ = false;
+    std::vector<std::thread> workers_;
+};
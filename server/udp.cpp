@@ -37,8 +37,23 @@ ssize_t udp_send_datagram(int fd, const char *buf, size_t len, const UdpPeer &pe
                     peer.addrlen);
 }
 
+int udp_recv_batch(int fd, struct mmsghdr *msgs, unsigned n)
+{
+    return ::recvmmsg(fd, msgs, n, MSG_WAITFORONE, nullptr);
+}
+
+int udp_send_batch(int fd, struct mmsghdr *msgs, unsigned n)
+{
+    unsigned done = 0;
+    while (done < n) {
+        int r = ::sendmmsg(fd, msgs + done, n - done, 0);
+        if (r <= 0) break;
+        done += static_cast<unsigned>(r);
+    }
+    return (done == 0 && n > 0) ? -1 : static_cast<int>(done);
+}
 
-int udp_create_socket(std::uint16_t port)
+int udp_create_socket(std::uint16_t port, bool reuse_port)
 {
     struct addrinfo hints{};
     struct addrinfo *res = nullptr;
@@ -69,6 +84,14 @@ int udp_create_socket(std::uint16_t port)
         std::perror("udp_create_socket: setsockopt");
     }
 
+    if (reuse_port &&
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        std::perror("udp_create_socket: setsockopt(SO_REUSEPORT)");
+        ::close(fd);
+        ::freeaddrinfo(res);
+        return -1;
+    }
+
     if (::bind(fd, res->ai_addr, res->ai_addrlen) < 0) {
         std::perror("udp_create_socket: bind");
         ::close(fd);
@@ -4,6 +4,7 @@
 
 #include <cstddef>
 #include <netinet/in.h>
+#include <sys/socket.h>
 #include <cstdint>
 
 // Informação sobre o peer que enviou o datagrama
@@ -13,8 +14,10 @@ struct UdpPeer {
 };
 
 // Cria e devolve o socket UDP já bindado ao porto.
+// Com reuse_port, activa SO_REUSEPORT para vários sockets no mesmo porto
+// (o kernel distribui os datagramas entre eles).
 // Retorna -1 em caso de erro.
-int udp_create_socket(std::uint16_t port);
+int udp_create_socket(std::uint16_t port, bool reuse_port = false);
 
 // Lê um datagrama do socket UDP.
 // Retorna nº de bytes lidos ou -1 em erro.
@@ -24,4 +27,12 @@ ssize_t udp_recv_datagram(int fd, char *buf, size_t maxlen, UdpPeer &peer);
 // Retorna nº de bytes enviados ou -1 em erro.
 ssize_t udp_send_datagram(int fd, const char *buf, size_t len, const UdpPeer &peer);
 
+// Lê até n datagramas de uma vez (recvmmsg). Num socket bloqueante só
+// espera pelo primeiro (MSG_WAITFORONE). Retorna nº lidos ou -1 em erro.
+int udp_recv_batch(int fd, struct mmsghdr *msgs, unsigned n);
+
+// Envia n datagramas numa só chamada (sendmmsg), repetindo se o kernel
+// aceitar só parte. Retorna nº enviados ou -1 se nenhum foi enviado.
+int udp_send_batch(int fd, struct mmsghdr *msgs, unsigned n);
+
 #endif
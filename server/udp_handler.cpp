@@ -5,340 +5,357 @@
 #include "reservations.h"
 #include "utils.h"
 #include "protocol.h"
+#include "stats.h"
+#include "commands.h"
 
 #include <arpa/inet.h>
 #include <dirent.h>
 #include <sys/stat.h>
 
-#include <algorithm>
+#include <charconv>
 #include <cstring>
 #include <ctime>
-#include <fstream>
 #include <iostream>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include "utils.h"
 
 
 
-// procura em EVENTS/*/RESERVATIONS/ um ficheiro com o nome dado.
-// devolve true e eid_out se encontrar.
-static bool find_event_for_resfile(const std::string &res_filename,
-                                   std::string &eid_out)
+// "CMD UID password" (o nº de campos já foi verificado no dispatch)
+static bool uid_pass_ok(const UdpTokens &t)
 {
-    DIR *dir = ::opendir("EVENTS");
-    if (!dir) return false;
-
-    struct dirent *ent;
-    while ((ent = ::readdir(dir)) != nullptr) {
-        if (ent->d_name[0] == '.') continue;
-        // directorias de 3 dígitos
-        if (std::strlen(ent->d_name) != 3) continue;
-
-        std::string eid = ent->d_name;
-        std::string path =
-            "EVENTS/" + eid + "/RESERVATIONS/" + res_filename;
-
-        if (file_exists(path)) {
-            ::closedir(dir);
-            eid_out = eid;
-            return true;
-        }
-    }
+    return proto_valid_uid(t.tok[1]) && proto_valid_password(t.tok[2]);
+}
 
-    ::closedir(dir);
-    return false;
+// "TAG STATUS\n"
+static void put_status(std::string &reply, const char *tag, UserStatus st)
+{
+    reply += tag;
+    reply += ' ';
+    reply += user_status_to_string(st);
+    reply += '\n';
 }
 
-// resumo de uma reserva (para LMR/RMR)
-struct ReservationSummary {
-    std::string eid;
-    std::string datetime; // "dd-mm-yyyy hh:mm:ss"
-    int         seats{};
-    std::time_t ts{};     // para ordenar (timestamp)
-};
+static void put_int(std::string &reply, int v)
+{
+    char buf[16];
+    const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    reply.append(buf, r.ptr);
+}
 
 //  LIN 
-static void handle_LIN(std::istringstream &iss, std::string &reply)
+static void handle_LIN(const UdpTokens &t, std::string &reply)
 {
-    std::string uid, pass, extra;
-    if (!(iss >> uid >> pass) || (iss >> extra) ||
-        !proto_valid_uid(uid) || !proto_valid_password(pass)) {
-        reply = "RLI ERR\n";
+    if (!uid_pass_ok(t)) {
+        reply += "RLI ERR\n";
         return;
     }
 
-    UserStatus st = es_user_login(uid, pass);
-    std::string status = user_status_to_string(st);
-    reply = "RLI " + status + "\n";
+    const std::string uid(t.tok[1]), pass(t.tok[2]);
+    put_status(reply, "RLI", es_user_login(uid, pass));
 }
 
 // LOU 
-static void handle_LOU(std::istringstream &iss, std::string &reply)
+static void handle_LOU(const UdpTokens &t, std::string &reply)
 {
-    std::string uid, pass, extra;
-    if (!(iss >> uid >> pass) || (iss >> extra) ||
-        !proto_valid_uid(uid) || !proto_valid_password(pass)) {
-        reply = "RLO ERR\n";
+    if (!uid_pass_ok(t)) {
+        reply += "RLO ERR\n";
         return;
     }
 
-    UserStatus st = es_user_logout(uid, pass);
-    std::string status = user_status_to_string(st);
-    reply = "RLO " + status + "\n";
+    const std::string uid(t.tok[1]), pass(t.tok[2]);
+    put_status(reply, "RLO", es_user_logout(uid, pass));
 }
 
 //  UNR 
-static void handle_UNR(std::istringstream &iss, std::string &reply)
+static void handle_UNR(const UdpTokens &t, std::string &reply)
 {
-    std::string uid, pass, extra;
-    if (!(iss >> uid >> pass) || (iss >> extra) ||
-        !proto_valid_uid(uid) || !proto_valid_password(pass)) {
-        reply = "RUR ERR\n";
+    if (!uid_pass_ok(t)) {
+        reply += "RUR ERR\n";
         return;
     }
 
-    UserStatus st = es_user_unregister(uid, pass);
-    std::string status = user_status_to_string(st);
-    reply = "RUR " + status + "\n";
+    const std::string uid(t.tok[1]), pass(t.tok[2]);
+    put_status(reply, "RUR", es_user_unregister(uid, pass));
 }
 
 //  LME (myevents) 
-static void handle_LME(std::istringstream &iss, std::string &reply)
+static void handle_LME(const UdpTokens &t, std::string &reply)
 {
-    std::string uid, pass, extra;
-    if (!(iss >> uid >> pass) || (iss >> extra) ||
-        !proto_valid_uid(uid) || !proto_valid_password(pass)) {
-        reply = "RME ERR\n";
+    if (!uid_pass_ok(t)) {
+        reply += "RME ERR\n";
         return;
     }
+    const std::string uid(t.tok[1]), pass(t.tok[2]);
 
     // password / login checks
     if (!es_user_exists(uid)) {
         // utilizador não existe ⇒ não tem eventos
-        reply = "RME NOK\n";
+        reply += "RME NOK\n";
         return;
     }
 
     if (!es_user_check_password(uid, pass)) {
-        reply = "RME WRP\n";
+        reply += "RME WRP\n";
         return;
     }
 
     if (!es_user_is_logged_in(uid)) {
-        reply = "RME NLG\n";
-        return;
-    }
-
-    std::string created_dir = "USERS/" + uid + "/CREATED";
-    DIR *dir = ::opendir(created_dir.c_str());
-    if (!dir) {
-        reply = "RME NOK\n";
+        reply += "RME NLG\n";
         return;
     }
 
     std::vector<std::string> eids;
-    struct dirent *ent;
-    while ((ent = ::readdir(dir)) != nullptr) {
-        if (ent->d_name[0] == '.') continue;
-
-        // esperamos ficheiros "001.txt"
-        std::string name = ent->d_name;
-        if (name.size() != 7 || name.substr(3) != ".txt") continue;
-
-        std::string eid = name.substr(0, 3);
-        eids.push_back(eid);
-    }
-    ::closedir(dir);
-
-    if (eids.empty()) {
-        reply = "RME NOK\n";
+    if (!es_user_created_events(uid, eids) || eids.empty()) {
+        reply += "RME NOK\n";
         return;
     }
 
-    std::sort(eids.begin(), eids.end());
-
-    std::ostringstream out;
-    out << "RME OK";
+    // " EID state" por evento
+    reply.reserve(8 + eids.size() * 6);
+    reply += "RME OK";
 
     for (const auto &eid : eids) {
         EventInfo info;
         if (!load_event(eid, info)) {
             continue; // ignora entradas estranhas
         }
-        int st = static_cast<int>(info.state);
-        out << " " << eid << " " << st;
+        reply += ' ';
+        reply += eid;
+        reply += ' ';
+        put_int(reply, static_cast<int>(info.state));
     }
-    out << "\n";
-    reply = out.str();
+    reply += '\n';
 }
 
 //  LMR (myreservations) 
-static void handle_LMR(std::istringstream &iss, std::string &reply)
+static void handle_LMR(const UdpTokens &t, std::string &reply)
 {
-    std::string uid, pass, extra;
-    if (!(iss >> uid >> pass) || (iss >> extra) ||
-        !proto_valid_uid(uid) || !proto_valid_password(pass)) {
-        reply = "RMR ERR\n";
+    if (!uid_pass_ok(t)) {
+        reply += "RMR ERR\n";
         return;
     }
+    const std::string uid(t.tok[1]), pass(t.tok[2]);
 
     if (!es_user_exists(uid)) {
         // utilizador não existe → não tem reservas
-        reply = "RMR NOK\n";
+        reply += "RMR NOK\n";
         return;
     }
 
     if (!es_user_check_password(uid, pass)) {
-        reply = "RMR WRP\n";
+        reply += "RMR WRP\n";
         return;
     }
 
     if (!es_user_is_logged_in(uid)) {
-        reply = "RMR NLG\n";
+        reply += "RMR NLG\n";
         return;
     }
 
-    std::string reserved_dir = "USERS/" + uid + "/RESERVED";
-    DIR *dir = ::opendir(reserved_dir.c_str());
-    if (!dir) {
-        // não há diretoria RESERVED → sem reservas
-        reply = "RMR NOK\n";
+    // já ordenadas (mais recente primeiro) e limitadas a 50
+    std::vector<ReservationRecord> recent;
+    if (!es_user_recent_reservations(uid, recent) || recent.empty()) {
+        reply += "RMR NOK\n";
         return;
     }
 
-    std::vector<ReservationSummary> all;
-    struct dirent *ent;
+    // protocolo: " EID date value", date = "dd-mm-yyyy hh:mm:ss"
+    reply.reserve(8 + recent.size() * 28);
+    reply += "RMR OK";
+    for (const auto &r : recent) {
+        reply += ' ';
+        reply += r.eid;
+        reply += ' ';
+        reply += r.datetime;
+        reply += ' ';
+        put_int(reply, r.seats);
+    }
+    reply += '\n';
+}
 
-    while ((ent = ::readdir(dir)) != nullptr) {
-        if (ent->d_name[0] == '.') continue;
 
-        std::string fname = ent->d_name; // ex: R-111111-2025-12-05 153000.txt
+using UdpHandler = void (*)(const UdpTokens &, std::string &);
 
-        // descobrir EID correspondente, olhando para EVENTS/*/RESERVATIONS/fname
-        std::string eid;
-        if (!find_event_for_resfile(fname, eid)) {
-            continue; // ficheiro estranho/inconsistente
-        }
-
-        std::string path = reserved_dir + "/" + fname;
-        std::ifstream in(path);
-        if (!in.is_open()) continue;
+struct UdpHandlers {
+    UdpHandler h[CMD_COUNT];
+};
 
-        std::string line;
-        if (!std::getline(in, line)) continue;
+static constexpr UdpHandlers udp_handlers()
+{
+    UdpHandlers t{};
+    t.h[cmd_index(CmdId::LIN)] = handle_LIN;
+    t.h[cmd_index(CmdId::LOU)] = handle_LOU;
+    t.h[cmd_index(CmdId::UNR)] = handle_UNR;
+    t.h[cmd_index(CmdId::LME)] = handle_LME;
+    t.h[cmd_index(CmdId::LMR)] = handle_LMR;
+    return t;
+}
 
-        std::istringstream ls(line);
-        std::string file_uid;
-        int seats = 0;
-        std::string dt1, dt2;
+static constexpr UdpHandlers UDP_HANDLERS = udp_handlers();
+static_assert(cmd_handlers_cover(UDP_HANDLERS.h, Transport::Udp),
+              "comando UDP sem handler (commands.h)");
 
-        // formato: UID res_num res_datetime
-        // res_datetime = "DD-MM-YYYY HH:MM:SS" -> dt1 + dt2
-        if (!(ls >> file_uid >> seats >> dt1 >> dt2)) {
-            continue;
-        }
 
-        std::string datetime = dt1 + " " + dt2;
+void udp_process_request(const char *buf, std::size_t n,
+                         const UdpPeer &peer, bool verbose,
+                         std::string &reply)
+{
+    UdpTokens t;
+    udp_tokenize(buf, n, t);
+    const std::string_view cmd = t.n > 0 ? t.tok[0] : std::string_view();
 
-        if (file_uid != uid || seats < 1 || seats > MAX_RESERVE_PEOPLE) {
-            continue;
-        }
+    if (verbose) {
+        std::string_view uid = t.n > 1 ? t.tok[1] : std::string_view();
+        if (!proto_valid_uid(uid)) uid = "------";
 
-        std::time_t ts = proto_parse_datetime_with_seconds(datetime);
-        if (ts == 0) continue;
+        char ip[INET_ADDRSTRLEN];
+        ::inet_ntop(AF_INET, &peer.addr.sin_addr, ip, sizeof(ip));
 
-        ReservationSummary r;
-        r.eid      = eid;
-        r.datetime = datetime;
-        r.seats    = seats;
-        r.ts       = ts;
-        all.push_back(std::move(r));
+        std::cout << "[ES][UDP] " << (cmd.empty() ? std::string_view("???") : cmd)
+                  << " UID=" << uid
+                  << " from " << ip
+                  << ":" << ntohs(peer.addr.sin_port)
+                  << "\n";
     }
 
-    ::closedir(dir);
+    // reply.clear() mantém a capacidade: o buffer é reutilizado entre pedidos
+    reply.clear();
 
-    if (all.empty()) {
-        reply = "RMR NOK\n";
+    const CommandInfo *c = cmd_lookup(cmd);
+    if (!c || c->transport != Transport::Udp) {
+        reply += "ERR\n";
         return;
     }
 
-    // ordenar por data/hora de reserva, mais recente primeiro
-    std::sort(all.begin(), all.end(),
-              [](const ReservationSummary &a,
-                 const ReservationSummary &b) {
-                  return a.ts > b.ts;
-              });
-
-    // Máximo 50 reservas (as 50 mais recentes)
-    if (all.size() > 50) {
-        all.resize(50);
+    const std::uint64_t t0 = stats_clock_ns();
+    if (t.n != static_cast<std::size_t>(1 + c->nargs)) {
+        reply += c->reply;
+        reply += " ERR\n";
+    } else {
+        UDP_HANDLERS.h[cmd_index(c->id)](t, reply);
     }
+    stats_command(c->id, stats_clock_ns() - t0);
+}
 
-    std::ostringstream out;
-    out << "RMR OK";
-    for (const auto &r : all) {
-        // protocolo: EID date value
-        // date = "dd-mm-yyyy hh:mm:ss"
-        out << " " << r.eid
-            << " " << r.datetime
-            << " " << r.seats;
-    }
-    out << "\n";
 
-    reply = out.str();
-}
+// tamanho máximo de um pedido UDP
+static const std::size_t UDP_REQ_MAX = 2048;
 
+// nº de datagramas por recvmmsg (1 = caminho clássico recvfrom/sendto)
+static std::size_t g_batch_size = 1;
 
-void udp_handle_datagram(int udp_fd, bool verbose)
+bool udp_handle_datagram(int udp_fd, bool verbose)
 {
-    char buf[2048];
+    char buf[UDP_REQ_MAX];
     UdpPeer peer{};
 
     ssize_t n = udp_recv_datagram(udp_fd, buf, sizeof(buf) - 1, peer);
-    if (n <= 0) {
-        return; // erro ou datagrama vazio
+    if (n < 0) {
+        return false; // erro (ou EAGAIN em modo não bloqueante)
+    }
+    if (n == 0) {
+        return true;  // datagrama vazio
     }
-    buf[n] = '\0';
 
-    if (verbose) {
-    std::istringstream tmp(buf);  
-    std::string cmd, uid;
-    tmp >> cmd >> uid;
-
-    if (!proto_valid_uid(uid)) uid = "------";
-    if (cmd.empty()) cmd = "???";
-
-    std::cout << "[ES][UDP] " << cmd
-              << " UID=" << uid
-              << " from " << inet_ntoa(peer.addr.sin_addr)
-              << ":" << ntohs(peer.addr.sin_port)
-              << "\n";
+    thread_local std::string reply;   // reutilizado (mantém a capacidade)
+    udp_process_request(buf, static_cast<std::size_t>(n), peer, verbose, reply);
+
+    if (!reply.empty()) {
+        udp_send_datagram(udp_fd, reply.c_str(), reply.size(), peer);
+    }
+    return true;
 }
 
 
-    std::string line(buf, n);
-    std::istringstream iss(line);
-    std::string cmd;
-    iss >> cmd;
-    std::string reply;
-
-    if (cmd == "LIN") {
-        handle_LIN(iss, reply);
-    } else if (cmd == "LOU") {
-        handle_LOU(iss, reply);
-    } else if (cmd == "UNR") {
-        handle_UNR(iss, reply);
-    } else if (cmd == "LME") {
-        handle_LME(iss, reply);
-    } else if (cmd == "LMR") {
-        handle_LMR(iss, reply);
-    } else {
-        reply = "ERR\n";
+void udp_set_batch_size(std::size_t n)
+{
+    if (n < 1) n = 1;
+    if (n > UDP_MAX_BATCH) n = UDP_MAX_BATCH;
+    g_batch_size = n;
+}
+
+// Buffers do batch, um conjunto por thread (shards correm em paralelo)
+struct UdpBatch {
+    std::vector<char>        bufs;
+    std::vector<mmsghdr>     in;
+    std::vector<mmsghdr>     out;
+    std::vector<iovec>       in_iov;
+    std::vector<iovec>       out_iov;
+    std::vector<UdpPeer>     peers;
+    std::vector<std::string> replies;
+
+    void resize(std::size_t n) {
+        if (in.size() == n) return;
+        bufs.assign(n * UDP_REQ_MAX, 0);
+        in.assign(n, mmsghdr{});
+        out.assign(n, mmsghdr{});
+        in_iov.assign(n, iovec{});
+        out_iov.assign(n, iovec{});
+        peers.assign(n, UdpPeer{});
+        replies.resize(n);
     }
+};
 
-    if (!reply.empty()) {
-        udp_send_datagram(udp_fd, reply.c_str(), reply.size(), peer);
+// recvmmsg -> trata cada pedido -> sendmmsg com todas as respostas
+static std::size_t udp_handle_batch(int udp_fd, bool verbose)
+{
+    thread_local UdpBatch b;
+    const std::size_t cap = g_batch_size;
+    b.resize(cap);
+
+    for (std::size_t i = 0; i < cap; ++i) {
+        b.in_iov[i].iov_base = b.bufs.data() + i * UDP_REQ_MAX;
+        b.in_iov[i].iov_len  = UDP_REQ_MAX - 1;
+
+        msghdr &h = b.in[i].msg_hdr;
+        h = msghdr{};
+        h.msg_name    = &b.peers[i].addr;
+        h.msg_namelen = sizeof(b.peers[i].addr);
+        h.msg_iov     = &b.in_iov[i];
+        h.msg_iovlen  = 1;
+    }
+
+    int n = udp_recv_batch(udp_fd, b.in.data(), static_cast<unsigned>(cap));
+    if (n <= 0) {
+        return 0; // erro ou EAGAIN
+    }
+    const std::size_t got = static_cast<std::size_t>(n);
+    stats_udp_batch(got, cap);
+
+    std::size_t nout = 0;
+    for (std::size_t i = 0; i < got; ++i) {
+        b.peers[i].addrlen = b.in[i].msg_hdr.msg_namelen;
+        const std::size_t len = b.in[i].msg_len;
+        if (len == 0) continue; // datagrama vazio
+
+        udp_process_request(static_cast<const char*>(b.in_iov[i].iov_base), len,
+                            b.peers[i], verbose, b.replies[i]);
+        if (b.replies[i].empty()) continue;
+
+        b.out_iov[nout].iov_base = b.replies[i].data();
+        b.out_iov[nout].iov_len  = b.replies[i].size();
+
+        msghdr &h = b.out[nout].msg_hdr;
+        h = msghdr{};
+        h.msg_name    = &b.peers[i].addr;
+        h.msg_namelen = b.peers[i].addrlen;
+        h.msg_iov     = &b.out_iov[nout];
+        h.msg_iovlen  = 1;
+        ++nout;
+    }
+
+    if (nout > 0) {
+        udp_send_batch(udp_fd, b.out.data(), static_cast<unsigned>(nout));
+    }
+    return got;
+}
+
+std::size_t udp_handle_ready(int udp_fd, bool verbose)
+{
+    if (g_batch_size <= 1) {
+        return udp_handle_datagram(udp_fd, verbose) ? 1 : 0;
     }
+    return udp_handle_batch(udp_fd, verbose);
 }
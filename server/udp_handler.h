@@ -1,8 +1,31 @@
 #ifndef ES_UDP_HANDLER_H
 #define ES_UDP_HANDLER_H
 
+#include <cstddef>
+#include <string>
+#include "udp.h"
+
 // Processa um único datagrama UDP recebido em udp_fd.
 // Se verbose==true, imprime info sobre o pedido.
-void udp_handle_datagram(int udp_fd, bool verbose);
+// Devolve false se não havia datagrama para ler (erro ou EAGAIN).
+bool udp_handle_datagram(int udp_fd, bool verbose);
+
+// Máximo de datagramas por batch (recvmmsg/sendmmsg)
+constexpr std::size_t UDP_MAX_BATCH = 256;
+
+// Define quantos datagramas udp_handle_ready lê por chamada
+// (1 = um recvfrom/sendto por pedido). Chamar antes de arrancar os loops.
+void udp_set_batch_size(std::size_t n);
+
+// Trata os datagramas disponíveis em udp_fd: um, ou até ao tamanho do
+// batch com recvmmsg + uma só sendmmsg para as respostas.
+// Devolve o nº de datagramas lidos (0 se não havia nenhum).
+std::size_t udp_handle_ready(int udp_fd, bool verbose);
+
+// Trata um pedido UDP já recebido (buf com n bytes) e deixa a resposta
+// em reply. Não faz I/O no socket: pode correr numa thread de trabalho.
+void udp_process_request(const char *buf, std::size_t n,
+                         const UdpPeer &peer, bool verbose,
+                         std::string &reply);
 
-#endif
\ No newline at end of file
+#endif
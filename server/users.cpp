@@ -1,16 +1,23 @@
 #include "users.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <string>
 #include <system_error>
 #include "protocol.h"
+#include "utils.h"
+#include "wal.h"
+#include "credentials.h"
 
 namespace fs = std::filesystem;
 
 // Diretoria base da BD de utilizadores 
 static const char *USERS_DIR = "USERS";
 
+// lockfile (flock) que serializa as alterações à BD de utilizadores
+static const char *USERS_LOCK_PATH = "USERS/.lock";
+
 
 // Helpers internos
 // USERS/UID
@@ -63,7 +70,7 @@ static void ensure_users_root()
 }
 
 
-std::string user_status_to_string(UserStatus st)
+const char *user_status_to_string(UserStatus st)
 {
     switch (st) {
     case UserStatus::OK:  return "OK";
@@ -78,18 +85,36 @@ std::string user_status_to_string(UserStatus st)
     return "ERR";
 }
 
+// Estado de USERS/uid: da tabela de credenciais ou, se ela não souber,
+// dos ficheiros.
+static CredState user_state(const std::string &uid)
+{
+    CredState st;
+    if (cred_lookup(uid, st)) return st;
+
+    std::error_code ec;
+    st.exists     = fs::exists(user_dir(uid), ec);
+    st.registered = st.exists && fs::exists(pass_file(uid), ec);
+    st.logged_in  = fs::exists(login_file(uid), ec);
+    if (st.registered) {
+        // pass.txt ilegível: nenhuma password coincide
+        st.digest = cred_digest(load_password(uid));
+    }
+    return st;
+}
+
 bool es_user_exists(const std::string &uid)
 {
+    if (wal_enabled()) return wal_user_exists(uid);
     if (!proto_valid_uid(uid)) return false;
-    std::error_code ec;
-    return fs::exists(user_dir(uid), ec) && fs::exists(pass_file(uid), ec);
+    return user_state(uid).registered;
 }
 
 bool es_user_is_logged_in(const std::string &uid)
 {
+    if (wal_enabled()) return wal_user_is_logged_in(uid);
     if (!proto_valid_uid(uid)) return false;
-    std::error_code ec;
-    return fs::exists(login_file(uid), ec);
+    return user_state(uid).logged_in;
 }
 
 
@@ -101,18 +126,19 @@ bool es_user_is_logged_in(const std::string &uid)
 UserStatus es_user_login(const std::string &uid,
                          const std::string &password)
 {
+    if (wal_enabled()) return wal_user_login(uid, password);
     if (!proto_valid_uid(uid) || !proto_valid_password(password)) return UserStatus::ERR;
 
     ensure_users_root();
+    FsLock lock(USERS_LOCK_PATH);
     std::error_code ec;
 
     fs::path udir = user_dir(uid);
 
-    bool dir_exists   = fs::exists(udir, ec);
-    bool pass_exists  = fs::exists(pass_file(uid), ec);
+    CredState st = user_state(uid);
 
     // 1: diretoria de utilizador não existe: novo registo
-    if (!dir_exists) {
+    if (!st.exists) {
         // criar USERS/UID, CREATED, RESERVED
         try {
             fs::create_directory(udir, ec);
@@ -127,63 +153,42 @@ UserStatus es_user_login(const std::string &uid,
         catch (...) {
             return UserStatus::ERR;
         }
+    }
 
+    // 1 e 2: sem conta (nova, ou já teve conta e fez unregister: herda
+    // CREATED/RESERVED)
+    if (!st.registered) {
         // criar pass.txt
         {
-            std::ofstream out(pass_file(uid));
-            if (!out.is_open()) return UserStatus::ERR;
-            out << password << "\n";
+            if (!write_file_atomic(pass_file(uid), password + "\n")) return UserStatus::ERR;
         }
 
         // criar login.txt 
         {
-            std::ofstream out(login_file(uid));
-            if (!out.is_open()) return UserStatus::ERR;
-            out << "Logged in\n";
-        }
-
-        return UserStatus::REG;
-    }
-
-    // 2: diretoria já existe, mas pass.txt não existe
-    // (utilizador já teve conta e fez unregister: herda CREATED/RESERVED)
-    if (!pass_exists) {
-        // criar novo pass.txt
-        {
-            std::ofstream out(pass_file(uid));
-            if (!out.is_open()) return UserStatus::ERR;
-            out << password << "\n";
-        }
-
-        // criar login.txt
-        {
-            std::ofstream out(login_file(uid));
-            if (!out.is_open()) return UserStatus::ERR;
-            out << "Logged in\n";
+            if (!write_file_atomic(login_file(uid), "Logged in\n")) return UserStatus::ERR;
         }
 
+        st.exists     = true;
+        st.registered = true;
+        st.logged_in  = true;
+        st.digest     = cred_digest(password);
+        cred_store(uid, st);
         return UserStatus::REG;
     }
 
     //3: utilizador já registado, verifica password
-    std::string saved = load_password(uid);
-    if (saved.empty()) {
-        // erro ao ler pass.txt
-        return UserStatus::ERR;
-    }
-
-    if (saved != password) {
+    if (!cred_password_ok(st, password)) {
         // password errada 
         return UserStatus::NOK;
     }
 
     // password correta: garantir login.txt 
     {
-        std::ofstream out(login_file(uid));
-        if (!out.is_open()) return UserStatus::ERR;
-        out << "Logged in\n";
+        if (!write_file_atomic(login_file(uid), "Logged in\n")) return UserStatus::ERR;
     }
 
+    st.logged_in = true;
+    cred_store(uid, st);
     return UserStatus::OK;
 }
 
@@ -196,32 +201,33 @@ UserStatus es_user_login(const std::string &uid,
 UserStatus es_user_logout(const std::string &uid,
                           const std::string &password)
 {
+    if (wal_enabled()) return wal_user_logout(uid, password);
     if (!proto_valid_uid(uid)) return UserStatus::ERR;
 
+    FsLock lock(USERS_LOCK_PATH);
     std::error_code ec;
 
-    if (!fs::exists(user_dir(uid), ec) || !fs::exists(pass_file(uid), ec)) {
+    CredState st = user_state(uid);
+    if (!st.registered) {
         // não há registo do utilizador
         return UserStatus::UNR;
     }
 
-    std::string saved = load_password(uid);
-    if (saved.empty()) return UserStatus::ERR;
-
-    if (saved != password) {
+    if (!cred_password_ok(st, password)) {
         return UserStatus::WRP;
     }
 
-    fs::path lfile = login_file(uid);
-    if (!fs::exists(lfile, ec)) {
+    if (!st.logged_in) {
         // não estava logged in
         return UserStatus::NOK;
     }
 
     // apaga login.txt
-    fs::remove(lfile, ec);
+    fs::remove(login_file(uid), ec);
     if (ec) return UserStatus::ERR;
-    
+
+    st.logged_in = false;
+    cred_store(uid, st);
     return UserStatus::OK;
 }
 
@@ -234,50 +240,46 @@ UserStatus es_user_logout(const std::string &uid,
 UserStatus es_user_unregister(const std::string &uid,
                               const std::string &password)
 {
+    if (wal_enabled()) return wal_user_unregister(uid, password);
     if (!proto_valid_uid(uid)) return UserStatus::ERR;
 
+    FsLock lock(USERS_LOCK_PATH);
     std::error_code ec;
 
-    if (!fs::exists(user_dir(uid), ec) || !fs::exists(pass_file(uid), ec)) {
+    CredState st = user_state(uid);
+    if (!st.registered) {
         return UserStatus::UNR;
     }
 
-    std::string saved = load_password(uid);
-    if (saved.empty()) return UserStatus::ERR;
-
-    if (saved != password) {
+    if (!cred_password_ok(st, password)) {
         return UserStatus::WRP;
     }
 
     // tem de estar logged in, senão NOK
-    fs::path lfile = login_file(uid);
-    if (!fs::exists(lfile, ec)) {
+    if (!st.logged_in) {
         return UserStatus::NOK;
     }
 
     // apaga pass.txt e login.txt, mas deixa CREATED/RESERVED intactos
     fs::remove(pass_file(uid), ec);
     if (ec) return UserStatus::ERR;
-    fs::remove(lfile, ec);
+    fs::remove(login_file(uid), ec);
     if (ec) return UserStatus::ERR;
 
+    st.registered = false;
+    st.logged_in  = false;
+    st.digest     = 0;
+    cred_store(uid, st);
     return UserStatus::OK;
 }
 
 bool es_user_check_password(const std::string &uid,
                             const std::string &password)
 {
+    if (wal_enabled()) return wal_user_check_password(uid, password);
     if (!proto_valid_uid(uid)) return false;
 
-    std::error_code ec;
-    if (!fs::exists(user_dir(uid), ec) || !fs::exists(pass_file(uid), ec)) {
-        return false;
-    }
-
-    std::string saved = load_password(uid);
-    if (saved.empty()) return false;
-
-    return (saved == password);
+    return cred_password_ok(user_state(uid), password);
 }
 
 
@@ -291,34 +293,57 @@ UserStatus es_user_change_password(const std::string &uid,
                                    const std::string &old_pass,
                                    const std::string &new_pass)
 {
+    if (wal_enabled()) return wal_user_change_password(uid, old_pass, new_pass);
     if (!proto_valid_uid(uid) || !proto_valid_password(old_pass) || !proto_valid_password(new_pass)) return UserStatus::ERR;
 
-    std::error_code ec;
+    FsLock lock(USERS_LOCK_PATH);
 
-    if (!fs::exists(user_dir(uid), ec) || !fs::exists(pass_file(uid), ec)) {
+    CredState st = user_state(uid);
+    if (!st.registered) {
         // utilizador não existe
         return UserStatus::NID;
     }
 
-    if (!fs::exists(login_file(uid), ec)) {
+    if (!st.logged_in) {
         // não está logged in
         return UserStatus::NLG;
     }
 
-    std::string saved = load_password(uid);
-    if (saved.empty()) return UserStatus::ERR;
-
-    if (saved != old_pass) {
+    if (!cred_password_ok(st, old_pass)) {
         // password antiga incorreta
         return UserStatus::NOK;
     }
 
     // escrever nova password
     {
-        std::ofstream out(pass_file(uid));
-        if (!out.is_open()) return UserStatus::ERR;
-        out << new_pass << "\n";
+        if (!write_file_atomic(pass_file(uid), new_pass + "\n")) return UserStatus::ERR;
     }
 
+    st.digest = cred_digest(new_pass);
+    cred_store(uid, st);
     return UserStatus::OK;
 }
+
+// LME: USERS/UID/CREATED/<eid>.txt
+bool es_user_created_events(const std::string &uid,
+                            std::vector<std::string> &eids_out)
+{
+    if (wal_enabled()) return wal_user_created_events(uid, eids_out);
+
+    eids_out.clear();
+    if (!proto_valid_uid(uid)) return false;
+
+    std::error_code ec;
+    fs::directory_iterator it(created_dir(uid), ec);
+    if (ec) return false;
+
+    for (const auto &ent : it) {
+        // esperamos ficheiros "001.txt"
+        std::string name = ent.path().filename().string();
+        if (name.size() != 7 || name.substr(3) != ".txt") continue;
+        eids_out.push_back(name.substr(0, 3));
+    }
+
+    std::sort(eids_out.begin(), eids_out.end());
+    return true;
+}
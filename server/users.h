@@ -2,6 +2,7 @@
 #define ES_USERS_H
 
 #include <string>
+#include <vector>
 
 // Estados para operações sobre utilizadores.
 // Mapeiam diretamente para as strings do protocolo.
@@ -17,7 +18,7 @@ enum class UserStatus {
 };
 
 // Converte UserStatus para a string usada no protocolo ("OK", "REG", etc.)
-std::string user_status_to_string(UserStatus st);
+const char *user_status_to_string(UserStatus st);
 
 // Helpers 
 bool es_user_exists(const std::string &uid);
@@ -44,4 +45,9 @@ UserStatus es_user_change_password(const std::string &uid,
 // Verifica se a password está correta para o utilizador
 bool es_user_check_password(const std::string &uid,
                             const std::string &password);
+
+// EIDs dos eventos criados pelo utilizador (LME), ordenados.
+// Devolve false se não houver registo nenhum.
+bool es_user_created_events(const std::string &uid,
+                            std::vector<std::string> &eids_out);
 #endif // ES_USERS_H
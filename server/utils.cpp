@@ -2,10 +2,15 @@
 
 #include <unistd.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <ctime>
 #include <fstream>
@@ -15,21 +20,6 @@
 
 
 
-std::string recv_line(int fd)
-{
-    std::string out;
-    out.reserve(256);
-
-    char c;
-    while (true) {
-        ssize_t n = ::read(fd, &c, 1);
-        if (n <= 0) break;          // erro ou EOF
-        out.push_back(c);
-        if (c == '\n') break;       // fim da linha
-    }
-    return out;
-}
-
 bool read_exact(int fd, void *buf, std::size_t n)
 {
     std::size_t done = 0;
@@ -70,4 +60,52 @@ bool read_first_line(const std::string &path, std::string &line_out) {
     }
     std::getline(in, line_out);
     return in.good() || !line_out.empty();
-}
\ No newline at end of file
+}
+
+
+bool write_file_atomic(const std::string &path, const std::string &content)
+{
+    // nome temporário único por processo/thread
+    static std::atomic<unsigned> seq{0};
+    const std::string tmp = path + ".tmp" + std::to_string(::getpid()) +
+                            "." + std::to_string(seq.fetch_add(1));
+
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if (!out.good()) {
+            out.close();
+            ::unlink(tmp.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+FsLock::FsLock(const char *path)
+{
+    fd = ::open(path, O_CREAT | O_RDWR | O_CLOEXEC, 0666);
+    if (fd < 0) return;
+
+    while (::flock(fd, LOCK_EX) < 0) {
+        if (errno == EINTR) continue;
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+}
+
+FsLock::~FsLock()
+{
+    if (fd >= 0) {
+        ::flock(fd, LOCK_UN);
+        ::close(fd);
+    }
+}
@@ -4,10 +4,6 @@
 #include <string>
 #include <cstddef>
 
-// Lê do socket até encontrar '\n' ou EOF.
-// Pode devolver string vazia em caso de erro/EOF antes de qualquer byte.
-std::string recv_line(int fd);
-
 // Lê exatamente n bytes (a não ser que haja erro/EOF). 
 // devolve true se conseguiu ler tudo, false se erro.
 bool read_exact(int fd, void *buf, std::size_t n);
@@ -21,4 +17,23 @@ bool file_exists(const std::string &path);
 // Lê a primeira linha do ficheiro, devolvendo true se conseguiu ler alguma coisa.
 bool read_first_line(const std::string &path, std::string &line_out);
 
+// Escreve o ficheiro inteiro de forma atómica (ficheiro temporário + rename),
+// para que leitores concorrentes vejam sempre o conteúdo antigo ou o novo.
+bool write_file_atomic(const std::string &path, const std::string &content);
+
+// Lock exclusivo (flock) sobre um ficheiro de lock.
+// Cada instância abre o seu próprio fd, por isso exclui tanto outros
+// processos como outras threads do mesmo processo.
+struct FsLock {
+    int fd = -1;
+
+    explicit FsLock(const char *path);
+    ~FsLock();
+
+    FsLock(const FsLock&) = delete;
+    FsLock &operator=(const FsLock&) = delete;
+
+    bool ok() const { return fd >= 0; }
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,786 @@
+// server/wal.cpp
+#include "wal.h"
+#include "protocol.h"
+#include "utils.h"      // write_exact, write_file_atomic, FsLock
+#include "io_backend.h"
+#include "datetime.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+const char *const WAL_DIR = "DB";
+
+// registos entre snapshots
+static const unsigned long long WAL_SNAPSHOT_EVERY = 4096;
+
+struct WalUser {
+    std::string pass;
+    bool        registered = false;
+    bool        logged_in  = false;
+    std::vector<std::string>       created;        // EIDs
+    std::vector<ReservationRecord> reservations;   // por ordem de chegada
+};
+
+struct WalEvent {
+    std::string owner_uid;
+    std::string name;
+    std::string desc_fname;
+    std::string event_date;   // "dd-mm-yyyy hh:mm"
+    std::time_t event_ts = 0;
+    int         capacity = 0;
+    int         reserved = 0;
+    bool        has_end  = false;
+    std::string end;          // "dd-mm-yyyy hh:mm:ss"
+};
+
+static pthread_mutex_t g_mu = PTHREAD_MUTEX_INITIALIZER;
+
+static bool        g_enabled = false;
+static int         g_log_fd  = -1;
+static std::string g_log_path;
+static std::string g_snap_path;
+static std::string g_lock_path;
+
+static off_t              g_off      = 0;   // bytes do log já aplicados
+static unsigned long long g_next_seq = 1;
+
+static std::map<std::string, WalUser>  g_users;
+static std::map<std::string, WalEvent> g_events;   // ordenado por EID (LST)
+static std::uint64_t g_events_version = 1;         // muda com o que o LST mostra
+
+struct WalGuard {
+    WalGuard()  { ::pthread_mutex_lock(&g_mu); }
+    ~WalGuard() { ::pthread_mutex_unlock(&g_mu); }
+};
+
+static void atfork_prepare() { ::pthread_mutex_lock(&g_mu); }
+static void atfork_release() { ::pthread_mutex_unlock(&g_mu); }
+
+
+// Registos
+
+static uint32_t fnv1a(const char *p, std::size_t n)
+{
+    uint32_t h = 2166136261u;
+    for (std::size_t i = 0; i < n; ++i) {
+        h ^= static_cast<unsigned char>(p[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// "<seq> <body> <crc>\n"
+static std::string make_record(unsigned long long seq, const std::string &body)
+{
+    std::string line = std::to_string(seq) + " " + body;
+    char crc[16];
+    std::snprintf(crc, sizeof(crc), " %08x\n",
+                  static_cast<unsigned>(fnv1a(line.data(), line.size())));
+    return line + crc;
+}
+
+static void split_fields(const char *p, std::size_t n, std::vector<std::string> &f)
+{
+    f.clear();
+    std::size_t i = 0;
+    while (i < n) {
+        std::size_t j = i;
+        while (j < n && p[j] != ' ') ++j;
+        if (j > i) f.emplace_back(p + i, j - i);
+        i = j + 1;
+    }
+}
+
+static bool to_int(const std::string &s, int &out)
+{
+    char *end = nullptr;
+    long v = std::strtol(s.c_str(), &end, 10);
+    if (s.empty() || *end != '\0' || v < 0 || v > 1000000) return false;
+    out = static_cast<int>(v);
+    return true;
+}
+
+static bool make_event(const std::string &owner, const std::string &name,
+                       const std::string &fname, const std::string &cap,
+                       const std::string &date, WalEvent &ev)
+{
+    ev.owner_uid  = owner;
+    ev.name       = name;
+    ev.desc_fname = fname;
+    ev.event_date = date;
+    if (!to_int(cap, ev.capacity)) return false;
+
+    return dt_parse_event(ev.event_date, ev.event_ts);
+}
+
+// f[0] = seq, f[1] = tipo
+static bool apply_record(const std::vector<std::string> &f)
+{
+    const std::string &type = f[1];
+    const std::size_t n = f.size();
+
+    if (type == "REG" && n == 4) {
+        WalUser &u = g_users[f[2]];
+        u.pass       = f[3];
+        u.registered = true;
+        u.logged_in  = true;
+        return true;
+    }
+    if (type == "LIN" && n == 3) {
+        g_users[f[2]].logged_in = true;
+        return true;
+    }
+    if (type == "LOU" && n == 3) {
+        g_users[f[2]].logged_in = false;
+        return true;
+    }
+    if (type == "UNR" && n == 3) {
+        // CREATED/RESERVED ficam (como no backend de ficheiros)
+        WalUser &u = g_users[f[2]];
+        u.pass.clear();
+        u.registered = false;
+        u.logged_in  = false;
+        return true;
+    }
+    if (type == "CPS" && n == 4) {
+        g_users[f[2]].pass = f[3];
+        return true;
+    }
+    if (type == "CRE" && n == 9) {
+        // CRE eid uid name fname attendance date time
+        WalEvent ev;
+        if (!make_event(f[3], f[4], f[5], f[6], f[7] + " " + f[8], ev)) return false;
+        g_events[f[2]] = std::move(ev);
+        g_users[f[3]].created.push_back(f[2]);
+        ++g_events_version;
+        return true;
+    }
+    if (type == "RID" && n == 7) {
+        // RID eid uid people date time
+        auto it = g_events.find(f[2]);
+        ReservationRecord r;
+        if (it == g_events.end() || !to_int(f[4], r.seats)) return false;
+        WalEvent &ev = it->second;
+        const bool was_full = ev.capacity > 0 && ev.reserved >= ev.capacity;
+        ev.reserved += r.seats;
+        if (!was_full && ev.capacity > 0 && ev.reserved >= ev.capacity) {
+            ++g_events_version;   // passou a SoldOut
+        }
+        r.eid      = f[2];
+        r.datetime = f[5] + " " + f[6];
+        g_users[f[3]].reservations.push_back(std::move(r));
+        return true;
+    }
+    if (type == "END" && n == 5) {
+        auto it = g_events.find(f[2]);
+        if (it == g_events.end()) return false;
+        it->second.has_end = true;
+        it->second.end     = f[3] + " " + f[4];
+        ++g_events_version;
+        return true;
+    }
+    return false;
+}
+
+// Valida e aplica uma linha (sem '\n'). Com g_mu.
+// Linhas com seq já coberto pelo snapshot são ignoradas.
+static bool apply_line(const char *p, std::size_t n)
+{
+    const char *sp = static_cast<const char*>(::memrchr(p, ' ', n));
+    if (!sp || p + n - sp != 9) return false;
+
+    const std::size_t body_len = static_cast<std::size_t>(sp - p);
+    char crc[9];
+    std::snprintf(crc, sizeof(crc), "%08x",
+                  static_cast<unsigned>(fnv1a(p, body_len)));
+    if (std::memcmp(crc, sp + 1, 8) != 0) return false;
+
+    std::vector<std::string> f;
+    split_fields(p, body_len, f);
+    if (f.size() < 2) return false;
+
+    unsigned long long seq = std::strtoull(f[0].c_str(), nullptr, 10);
+    if (seq < g_next_seq) return true;
+    if (seq != g_next_seq || !apply_record(f)) return false;
+
+    ++g_next_seq;
+    return true;
+}
+
+// Aplica as linhas completas do log a partir de g_off. Pára na primeira
+// linha inválida (cauda cortada). Com g_mu.
+static void catch_up_locked()
+{
+    char buf[64 * 1024];
+    std::string pending;
+    off_t pos = g_off;
+
+    while (true) {
+        ssize_t n = ::pread(g_log_fd, buf, sizeof(buf), pos);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        pos += n;
+        pending.append(buf, static_cast<std::size_t>(n));
+
+        std::size_t start = 0, nl;
+        while ((nl = pending.find('\n', start)) != std::string::npos) {
+            if (!apply_line(pending.data() + start, nl - start)) return;
+            g_off += static_cast<off_t>(nl - start + 1);
+            start = nl + 1;
+        }
+        pending.erase(0, start);
+    }
+}
+
+
+// Snapshot
+//   SNAP next_seq offset
+//   U uid registered logged_in pass|-
+//   C uid eid
+//   R uid eid seats date time
+//   E eid owner name fname capacity date time reserved end|- [end_date end_time]
+
+static bool write_snapshot_locked(off_t offset)
+{
+    std::ostringstream out;
+    out << "SNAP " << g_next_seq << " " << offset << "\n";
+
+    for (const auto &kv : g_events) {
+        const WalEvent &e = kv.second;
+        out << "E " << kv.first << " " << e.owner_uid << " " << e.name << " "
+            << e.desc_fname << " " << e.capacity << " " << e.event_date << " "
+            << e.reserved << " " << (e.has_end ? e.end : "-") << "\n";
+    }
+    for (const auto &kv : g_users) {
+        const WalUser &u = kv.second;
+        out << "U " << kv.first << " " << u.registered << " " << u.logged_in << " "
+            << (u.pass.empty() ? "-" : u.pass) << "\n";
+        for (const auto &eid : u.created) {
+            out << "C " << kv.first << " " << eid << "\n";
+        }
+        for (const auto &r : u.reservations) {
+            out << "R " << kv.first << " " << r.eid << " " << r.seats << " "
+                << r.datetime << "\n";
+        }
+    }
+
+    return write_file_atomic(g_snap_path, out.str());
+}
+
+// Sem snapshot: BD vazia. Snapshot ilegível: erro (o log pode já ter
+// sido compactado, não há de onde reconstruir).
+static bool load_snapshot_locked()
+{
+    std::string data;
+    if (!io_read_file(g_snap_path, data)) return true;
+
+    std::istringstream in(data);
+    std::string line, tag;
+    if (!std::getline(in, line)) return false;
+
+    {
+        std::istringstream ls(line);
+        unsigned long long seq = 0;
+        long long off = 0;
+        if (!(ls >> tag >> seq >> off) || tag != "SNAP" || seq == 0 || off < 0) return false;
+        g_next_seq = seq;
+        g_off      = static_cast<off_t>(off);
+    }
+
+    std::vector<std::string> f;
+    while (std::getline(in, line)) {
+        split_fields(line.data(), line.size(), f);
+        if (f.empty()) continue;
+
+        if (f[0] == "E" && (f.size() == 10 || f.size() == 11)) {
+            WalEvent ev;
+            if (!make_event(f[2], f[3], f[4], f[5], f[6] + " " + f[7], ev) ||
+                !to_int(f[8], ev.reserved)) {
+                return false;
+            }
+            if (f.size() == 11) {
+                ev.has_end = true;
+                ev.end     = f[9] + " " + f[10];
+            }
+            g_events[f[1]] = std::move(ev);
+        } else if (f[0] == "U" && f.size() == 5) {
+            WalUser &u = g_users[f[1]];
+            u.registered = f[2] == "1";
+            u.logged_in  = f[3] == "1";
+            u.pass       = f[4] == "-" ? "" : f[4];
+        } else if (f[0] == "C" && f.size() == 3) {
+            g_users[f[1]].created.push_back(f[2]);
+        } else if (f[0] == "R" && f.size() == 6) {
+            ReservationRecord r;
+            r.eid      = f[2];
+            r.datetime = f[4] + " " + f[5];
+            if (!to_int(f[3], r.seats)) return false;
+            g_users[f[1]].reservations.push_back(std::move(r));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// Escrita
+
+// g_mu + flock do log, já em dia com o que os outros escreveram
+struct WalWriter {
+    WalGuard g;
+    FsLock   lock;
+
+    WalWriter() : lock(g_lock_path.c_str())
+    {
+        catch_up_locked();
+
+        // bytes depois da última linha válida são de um escritor que
+        // morreu a meio: com o lock na mão, podem ir fora
+        struct stat st{};
+        if (::fstat(g_log_fd, &st) == 0 && st.st_size > g_off) {
+            if (::ftruncate(g_log_fd, g_off) != 0) {}
+        }
+    }
+};
+
+// Acrescenta e aplica um registo. Só dentro de um WalWriter.
+static bool append_locked(const std::string &body)
+{
+    const std::string rec = make_record(g_next_seq, body);
+
+    if (!write_exact(g_log_fd, rec.data(), rec.size())) {
+        // não deixar meia linha no fim do log
+        if (::ftruncate(g_log_fd, g_off) != 0) {}
+        return false;
+    }
+
+    apply_line(rec.data(), rec.size() - 1);
+    g_off += static_cast<off_t>(rec.size());
+
+    if (g_next_seq % WAL_SNAPSHOT_EVERY == 0) {
+        write_snapshot_locked(g_off);
+    }
+    return true;
+}
+
+// "dd-mm-yyyy hh:mm:ss" da hora actual
+static bool now_datetime(std::string &out)
+{
+    char buf[DT_SECONDS_LEN + 1];
+    dt_format_seconds(dt_now(), buf);
+    out = buf;
+    return true;
+}
+
+static void fill_event_info(const std::string &eid, const WalEvent &e, EventInfo &out)
+{
+    out.eid          = eid;
+    out.owner_uid    = e.owner_uid;
+    out.name         = e.name;
+    out.desc_fname   = e.desc_fname;
+    out.event_date   = e.event_date;
+    out.event_ts     = e.event_ts;
+    out.capacity     = e.capacity;
+    out.reserved     = e.reserved;
+    out.has_end_file = e.has_end;
+    event_compute_state(out, e.has_end ? &e.end : nullptr);
+}
+
+static WalUser *find_user(const std::string &uid)
+{
+    auto it = g_users.find(uid);
+    return it == g_users.end() ? nullptr : &it->second;
+}
+
+
+bool wal_open(const std::string &dir)
+{
+    static bool atfork_done = false;
+    if (!atfork_done) {
+        ::pthread_atfork(atfork_prepare, atfork_release, atfork_release);
+        atfork_done = true;
+    }
+
+    WalGuard g;
+
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+
+    g_log_path  = dir + "/es.log";
+    g_snap_path = dir + "/es.snap";
+    g_lock_path = dir + "/es.lock";
+
+    g_log_fd = ::open(g_log_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (g_log_fd < 0) return false;
+
+    FsLock lock(g_lock_path.c_str());
+    if (!lock.ok() || !load_snapshot_locked()) {
+        ::close(g_log_fd);
+        g_log_fd = -1;
+        return false;
+    }
+
+    // replay; o que não se aplicou é cauda cortada
+    catch_up_locked();
+
+    // compactar: o snapshot passa a valer desde o offset 0 e o log fica
+    // vazio. Se morrermos entre os dois passos, o replay ignora pelo seq
+    // o que o snapshot já tem.
+    struct stat st{};
+    if (::fstat(g_log_fd, &st) == 0 && st.st_size > 0) {
+        if (!write_snapshot_locked(0) || ::ftruncate(g_log_fd, 0) != 0) {
+            ::close(g_log_fd);
+            g_log_fd = -1;
+            return false;
+        }
+        g_off = 0;
+    }
+
+    g_enabled = true;
+    return true;
+}
+
+bool wal_enabled()
+{
+    return g_enabled;
+}
+
+
+// Eventos
+
+bool wal_load_event(const std::string &eid, EventInfo &out)
+{
+    WalGuard g;
+    catch_up_locked();
+
+    auto it = g_events.find(eid);
+    if (it == g_events.end()) return false;
+    fill_event_info(eid, it->second, out);
+    return true;
+}
+
+std::uint64_t wal_events_version()
+{
+    WalGuard g;
+    catch_up_locked();
+    return g_events_version;
+}
+
+std::vector<EventInfo> wal_load_all_events()
+{
+    std::vector<EventInfo> events;
+    WalGuard g;
+    catch_up_locked();
+
+    events.reserve(g_events.size());
+    for (const auto &kv : g_events) {
+        events.emplace_back();
+        fill_event_info(kv.first, kv.second, events.back());
+    }
+    return events;
+}
+
+std::vector<EventInfo> wal_list_events(const EventFilter &f, const std::string &after,
+                                       std::size_t limit, bool &more)
+{
+    std::vector<EventInfo> out;
+    more = false;
+    WalGuard g;
+    catch_up_locked();
+
+    // true: página cheia e há mais
+    auto visit = [&](const std::string &eid, const WalEvent &e) {
+        EventInfo ev;
+        fill_event_info(eid, e, ev);
+        if (!event_matches(f, ev)) return false;
+        if (out.size() == limit) {
+            more = true;
+            return true;
+        }
+        out.push_back(std::move(ev));
+        return false;
+    };
+
+    if (!f.owner.empty()) {
+        // created do dono como índice (por ordem de criação)
+        const WalUser *u = find_user(f.owner);
+        if (!u) return out;
+        std::vector<std::string> eids;
+        for (const auto &eid : u->created) {
+            if (eid > after) eids.push_back(eid);
+        }
+        std::sort(eids.begin(), eids.end());
+        for (const auto &eid : eids) {
+            auto it = g_events.find(eid);
+            if (it != g_events.end() && visit(it->first, it->second)) break;
+        }
+        return out;
+    }
+
+    for (auto it = g_events.upper_bound(after); it != g_events.end(); ++it) {
+        if (visit(it->first, it->second)) break;
+    }
+    return out;
+}
+
+bool wal_create_event(const std::string &uid,
+                      const std::string &name,
+                      const std::string &date_part,
+                      const std::string &time_part,
+                      int attendance,
+                      const std::string &fname,
+                      const std::string &staged_path,
+                      std::string &eid_out)
+{
+    WalWriter w;
+
+    // menor EID livre
+    std::string eid;
+    for (int i = 1; i <= 999 && eid.empty(); ++i) {
+        char buf[4];
+        std::snprintf(buf, sizeof(buf), "%03d", i);
+        if (g_events.find(buf) == g_events.end()) eid = buf;
+    }
+    if (eid.empty()) return false;
+
+    // Fdata fica em EVENTS/<eid>/DESCRIPTION, como no backend de ficheiros
+    const std::string desc_dir = event_dir(eid) + "/DESCRIPTION";
+    std::error_code ec;
+    fs::create_directories(desc_dir, ec);
+    if (ec) return false;
+
+    const std::string fpath = desc_dir + "/" + fname;
+    if (::rename(staged_path.c_str(), fpath.c_str()) != 0) return false;
+
+    if (!append_locked("CRE " + eid + " " + uid + " " + name + " " + fname + " " +
+                       std::to_string(attendance) + " " + date_part + " " + time_part)) {
+        // sem registo o EID continua livre: desfazer o rename para não
+        // ficar um DESCRIPTION órfão (o staged é apagado por quem chama)
+        if (::rename(fpath.c_str(), staged_path.c_str()) != 0) ::unlink(fpath.c_str());
+        ::rmdir(desc_dir.c_str());
+        ::rmdir(event_dir(eid).c_str());
+        return false;
+    }
+
+    eid_out = eid;
+    return true;
+}
+
+bool wal_ensure_end_if_past(const std::string &eid)
+{
+    WalWriter w;
+
+    auto it = g_events.find(eid);
+    if (it == g_events.end()) return false;
+    if (it->second.has_end) return true;
+
+    // END com a data/hora do próprio evento ("dd-mm-yyyy hh:mm:00")
+    return append_locked("END " + eid + " " + it->second.event_date + ":00");
+}
+
+bool wal_close_event(const std::string &eid)
+{
+    WalWriter w;
+
+    auto it = g_events.find(eid);
+    if (it == g_events.end() || it->second.has_end) return false;
+
+    std::string now;
+    if (!now_datetime(now)) return false;
+    return append_locked("END " + eid + " " + now);
+}
+
+
+// Utilizadores
+
+bool wal_user_exists(const std::string &uid)
+{
+    WalGuard g;
+    catch_up_locked();
+    const WalUser *u = find_user(uid);
+    return u && u->registered;
+}
+
+bool wal_user_is_logged_in(const std::string &uid)
+{
+    WalGuard g;
+    catch_up_locked();
+    const WalUser *u = find_user(uid);
+    return u && u->logged_in;
+}
+
+bool wal_user_check_password(const std::string &uid, const std::string &password)
+{
+    WalGuard g;
+    catch_up_locked();
+    const WalUser *u = find_user(uid);
+    return u && u->registered && u->pass == password;
+}
+
+UserStatus wal_user_login(const std::string &uid, const std::string &password)
+{
+    if (!proto_valid_uid(uid) || !proto_valid_password(password)) return UserStatus::ERR;
+
+    WalWriter w;
+    const WalUser *u = find_user(uid);
+
+    if (!u || !u->registered) {
+        return append_locked("REG " + uid + " " + password) ? UserStatus::REG
+                                                             : UserStatus::ERR;
+    }
+    if (u->pass != password) return UserStatus::NOK;
+    if (u->logged_in) return UserStatus::OK;
+
+    return append_locked("LIN " + uid) ? UserStatus::OK : UserStatus::ERR;
+}
+
+// LOU e UNR: mesmas verificações, muda só o registo
+static UserStatus logout_or_unregister(const std::string &uid,
+                                       const std::string &password,
+                                       const char *type)
+{
+    if (!proto_valid_uid(uid)) return UserStatus::ERR;
+
+    WalWriter w;
+    const WalUser *u = find_user(uid);
+
+    if (!u || !u->registered) return UserStatus::UNR;
+    if (u->pass != password)  return UserStatus::WRP;
+    if (!u->logged_in)        return UserStatus::NOK;
+
+    return append_locked(std::string(type) + " " + uid) ? UserStatus::OK
+                                                        : UserStatus::ERR;
+}
+
+UserStatus wal_user_logout(const std::string &uid, const std::string &password)
+{
+    return logout_or_unregister(uid, password, "LOU");
+}
+
+UserStatus wal_user_unregister(const std::string &uid, const std::string &password)
+{
+    return logout_or_unregister(uid, password, "UNR");
+}
+
+UserStatus wal_user_change_password(const std::string &uid,
+                                    const std::string &old_pass,
+                                    const std::string &new_pass)
+{
+    if (!proto_valid_uid(uid) || !proto_valid_password(old_pass) ||
+        !proto_valid_password(new_pass)) {
+        return UserStatus::ERR;
+    }
+
+    WalWriter w;
+    const WalUser *u = find_user(uid);
+
+    if (!u || !u->registered) return UserStatus::NID;
+    if (!u->logged_in)        return UserStatus::NLG;
+    if (u->pass != old_pass)  return UserStatus::NOK;
+
+    return append_locked("CPS " + uid + " " + new_pass) ? UserStatus::OK
+                                                        : UserStatus::ERR;
+}
+
+bool wal_user_created_events(const std::string &uid, std::vector<std::string> &eids_out)
+{
+    WalGuard g;
+    catch_up_locked();
+
+    eids_out.clear();
+    const WalUser *u = find_user(uid);
+    if (!u) return false;
+
+    eids_out = u->created;
+    std::sort(eids_out.begin(), eids_out.end());
+    return true;
+}
+
+
+// Reservas
+
+ReserveStatus wal_make_reservation(const std::string &uid,
+                                   const std::string &pass,
+                                   const std::string &eid,
+                                   int people,
+                                   int &remaining_out)
+{
+    remaining_out = 0;
+
+    WalWriter w;
+
+    const WalUser *u = find_user(uid);
+    if (!u || !u->registered || !u->logged_in) return ReserveStatus::NLG;
+    if (u->pass != pass) return ReserveStatus::WRP;
+
+    auto it = g_events.find(eid);
+    if (it == g_events.end()) return ReserveStatus::NOK;
+
+    EventInfo ev;
+    fill_event_info(eid, it->second, ev);
+
+    if (ev.state == EventState::Past)         return ReserveStatus::PST;
+    if (ev.state == EventState::ClosedByUser) return ReserveStatus::CLS;
+    if (ev.state == EventState::SoldOut)      return ReserveStatus::SLD;
+
+    const int remaining = ev.capacity - ev.reserved;
+    if (remaining <= 0) return ReserveStatus::SLD;
+    if (people > remaining) {
+        remaining_out = remaining;
+        return ReserveStatus::REJ;
+    }
+
+    std::string now;
+    if (!now_datetime(now)) return ReserveStatus::NOK;
+
+    if (!append_locked("RID " + eid + " " + uid + " " + std::to_string(people) + " " + now)) {
+        return ReserveStatus::NOK;
+    }
+    return ReserveStatus::ACC;
+}
+
+bool wal_user_reservations(const std::string &uid, std::vector<ReservationRecord> &out)
+{
+    WalGuard g;
+    catch_up_locked();
+
+    out.clear();
+    const WalUser *u = find_user(uid);
+    if (!u) return false;
+
+    out = u->reservations;
+    return true;
+}
+
+bool wal_user_recent_reservations(const std::string &uid, std::vector<ReservationRecord> &out)
+{
+    WalGuard g;
+    catch_up_locked();
+
+    out.clear();
+    const WalUser *u = find_user(uid);
+    if (!u) return false;
+
+    // por ordem do log, que é a ordem temporal: as últimas, ao contrário
+    const auto &all = u->reservations;
+    const std::size_t n = std::min(all.size(), static_cast<std::size_t>(LMR_MAX_RESERVATIONS));
+    out.assign(all.rbegin(), all.rbegin() + static_cast<std::ptrdiff_t>(n));
+    return true;
+}
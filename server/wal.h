@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "events.h"
+#include "users.h"
+#include "reservations.h"
+
+// Backend de armazenamento alternativo (--storage wal): em vez da árvore
+// EVENTS/ + USERS/ de ficheiros pequenos, um log só de acréscimo
+// (DB/es.log) com um índice em memória.
+//
+//  - cada operação que muda dados é uma linha "<seq> TIPO campos... <fnv1a>"
+//    escrita com um só write() (O_APPEND) sob flock(DB/es.lock);
+//  - cada processo tem o seu índice e, antes de ler ou escrever, aplica o
+//    que outros processos (fork/prefork) acrescentaram ao log;
+//  - de WAL_SNAPSHOT_EVERY em WAL_SNAPSHOT_EVERY registos grava-se o índice
+//    em DB/es.snap (temporário + rename) com o offset do log até onde vale;
+//  - no arranque: snapshot + replay do resto do log; uma cauda cortada ou
+//    com checksum errado (crash a meio de um write) é descartada e o log é
+//    compactado (snapshot novo + log vazio).
+//
+// Os ficheiros de descrição continuam em EVENTS/<eid>/DESCRIPTION/ (SED
+// envia-os com sendfile); o log só guarda metadados.
+
+extern const char *const WAL_DIR;
+
+// Abre/recupera a BD em dir e passa todas as operações es_* para o log.
+// Chamar no arranque, antes de criar threads ou processos.
+bool wal_open(const std::string &dir);
+
+bool wal_enabled();
+
+// events.h
+bool wal_load_event(const std::string &eid, EventInfo &out);
+std::vector<EventInfo> wal_load_all_events();
+// Muda com CRE, END e reservas que esgotam um evento
+std::uint64_t wal_events_version();
+std::vector<EventInfo> wal_list_events(const EventFilter &f, const std::string &after,
+                                       std::size_t limit, bool &more);
+bool wal_create_event(const std::string &uid,
+                      const std::string &name,
+                      const std::string &date_part,
+                      const std::string &time_part,
+                      int attendance,
+                      const std::string &fname,
+                      const std::string &staged_path,
+                      std::string &eid_out);
+bool wal_ensure_end_if_past(const std::string &eid);
+bool wal_close_event(const std::string &eid);
+
+// users.h
+bool wal_user_exists(const std::string &uid);
+bool wal_user_is_logged_in(const std::string &uid);
+bool wal_user_check_password(const std::string &uid, const std::string &password);
+UserStatus wal_user_login(const std::string &uid, const std::string &password);
+UserStatus wal_user_logout(const std::string &uid, const std::string &password);
+UserStatus wal_user_unregister(const std::string &uid, const std::string &password);
+UserStatus wal_user_change_password(const std::string &uid,
+                                    const std::string &old_pass,
+                                    const std::string &new_pass);
+bool wal_user_created_events(const std::string &uid, std::vector<std::string> &eids_out);
+
+// reservations.h
+ReserveStatus wal_make_reservation(const std::string &uid,
+                                   const std::string &pass,
+                                   const std::string &eid,
+                                   int people,
+                                   int &remaining_out);
+bool wal_user_reservations(const std::string &uid, std::vector<ReservationRecord> &out);
+bool wal_user_recent_reservations(const std::string &uid, std::vector<ReservationRecord> &out);
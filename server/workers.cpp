@@ -0,0 +1,260 @@
+// server/workers.cpp
+#include "workers.h"
+#include "catalog.h"
+#include "tcp.h"
+#include "tcp_handler.h"
+#include "udp.h"
+#include "udp_handler.h"
+#include "thread_pool.h"
+
+#include <iostream>
+#include <csignal>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/select.h>
+#include <sys/wait.h>
+#include <arpa/inet.h>
+
+// Prefork
+
+static const std::size_t MAX_PREFORK_WORKERS = 256;
+
+static pid_t                 g_workers[MAX_PREFORK_WORKERS];
+static volatile std::size_t  g_nworkers = 0;
+static volatile sig_atomic_t g_child_exited = 0;
+static volatile sig_atomic_t g_shutting_down = 0;
+
+static void prefork_sigchld_handler(int)
+{
+    // o reaping é feito no loop principal, para saber que filho morreu
+    g_child_exited = 1;
+}
+
+[[noreturn]] static void prefork_child(pid_t parent, int listen_fd, int udp_fd, bool verbose)
+{
+    // o pai sai com _Exit na thread dos sinais: um worker criado ao mesmo
+    // tempo que o prefork_shutdown não ficava na lista e sobrevivia-lhe
+    ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+    if (::getppid() != parent) std::_Exit(0);
+
+    if (udp_fd >= 0) ::close(udp_fd);
+    udp_shards_close();
+
+    // o filho não gere o pool: handlers por omissão
+    g_nworkers = 0;
+    struct sigaction sa{};
+    sa.sa_handler = SIG_DFL;
+    ::sigemptyset(&sa.sa_mask);
+    ::sigaction(SIGCHLD, &sa, nullptr);
+    ::sigaction(SIGINT, &sa, nullptr);
+    ::sigaction(SIGTERM, &sa, nullptr);
+
+    // worker de longa duração: catálogo e inotify próprios
+    if (catalog_active()) catalog_init();
+
+    while (true) {
+        char ip[INET_ADDRSTRLEN];
+        std::uint16_t port = 0;
+
+        int cfd = tcp_accept_client(listen_fd, verbose, ip, sizeof(ip), port);
+        if (cfd < 0) continue;
+
+        tcp_handle_connection(cfd, verbose, ip, port);
+    }
+}
+
+static pid_t prefork_spawn(int listen_fd, int udp_fd, bool verbose)
+{
+    const pid_t parent = ::getpid();
+    pid_t pid = ::fork();
+    if (pid < 0) {
+        std::perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        prefork_child(parent, listen_fd, udp_fd, verbose);
+    }
+    return pid;
+}
+
+void prefork_shutdown()
+{
+    g_shutting_down = 1;
+    for (std::size_t i = 0; i < g_nworkers; ++i) {
+        if (g_workers[i] > 0) ::kill(g_workers[i], SIGTERM);
+    }
+}
+
+int prefork_run(int listen_fd, int udp_fd, std::size_t nworkers, bool verbose)
+{
+    if (nworkers == 0) nworkers = 1;
+    if (nworkers > MAX_PREFORK_WORKERS) nworkers = MAX_PREFORK_WORKERS;
+
+    // um worker por ligação: sem KAL (tcp_set_keepalive_allowed)
+    tcp_set_keepalive_allowed(false);
+
+    struct sigaction sa{};
+    sa.sa_handler = prefork_sigchld_handler;
+    ::sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0;   // sem SA_RESTART: acorda o select()
+    ::sigaction(SIGCHLD, &sa, nullptr);
+
+    for (std::size_t i = 0; i < nworkers; ++i) {
+        g_workers[i] = prefork_spawn(listen_fd, udp_fd, verbose);
+        g_nworkers = i + 1;
+    }
+
+    while (true) {
+        if (g_child_exited) {
+            g_child_exited = 0;
+
+            pid_t dead;
+            while ((dead = ::waitpid(-1, nullptr, WNOHANG)) > 0) {
+                for (std::size_t i = 0; i < g_nworkers; ++i) {
+                    if (g_workers[i] != dead || g_shutting_down) continue;
+                    if (verbose) {
+                        std::cout << "[ES] Worker " << dead << " exited, respawning\n";
+                    }
+                    g_workers[i] = prefork_spawn(listen_fd, udp_fd, verbose);
+                }
+            }
+        }
+
+        // sem UDP (shards): o select só acorda com SIGCHLD
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        if (udp_fd >= 0) FD_SET(udp_fd, &readfds);
+
+        int ready = ::select(udp_fd + 1, &readfds, nullptr, nullptr, nullptr);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::perror("select");
+            break;
+        }
+
+        if (udp_fd >= 0 && FD_ISSET(udp_fd, &readfds)) {
+            udp_handle_ready(udp_fd, verbose);
+        }
+    }
+
+    prefork_shutdown();
+    return -1;
+}
+
+
+// Threads
+
+int threads_run(int listen_fd, int udp_fd, std::size_t nthreads,
+                std::size_t queue_max, bool verbose)
+{
+    ThreadPool pool(nthreads, queue_max);
+
+    // uma thread por ligação: sem KAL (tcp_set_keepalive_allowed)
+    tcp_set_keepalive_allowed(false);
+
+    while (true) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        if (udp_fd >= 0) FD_SET(udp_fd, &readfds);
+        FD_SET(listen_fd, &readfds);
+
+        int maxfd = (udp_fd > listen_fd) ? udp_fd : listen_fd;
+
+        int ready = ::select(maxfd + 1, &readfds, nullptr, nullptr, nullptr);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::perror("select");
+            break;
+        }
+
+        // UDP: recebe aqui, trata e responde numa thread do pool
+        if (udp_fd >= 0 && FD_ISSET(udp_fd, &readfds)) {
+            char buf[2048];
+            UdpPeer peer{};
+
+            ssize_t n = udp_recv_datagram(udp_fd, buf, sizeof(buf) - 1, peer);
+            if (n > 0) {
+                std::string req(buf, static_cast<std::size_t>(n));
+                pool.submit([udp_fd, verbose, peer, req] {
+                    std::string reply;
+                    udp_process_request(req.data(), req.size(), peer, verbose, reply);
+                    if (!reply.empty()) {
+                        udp_send_datagram(udp_fd, reply.c_str(), reply.size(), peer);
+                    }
+                });
+            }
+        }
+
+        // TCP: accept aqui, ligação inteira numa thread do pool
+        if (FD_ISSET(listen_fd, &readfds)) {
+            char ip[INET_ADDRSTRLEN];
+            std::uint16_t port = 0;
+
+            int cfd = tcp_accept_client(listen_fd, verbose, ip, sizeof(ip), port);
+            if (cfd >= 0) {
+                std::string ip_s(ip);
+                pool.submit([cfd, verbose, ip_s, port] {
+                    tcp_handle_connection(cfd, verbose, ip_s.c_str(), port);
+                });
+            }
+        }
+    }
+
+    return -1;
+}
+
+
+// UDP shards
+
+// Os shards tratam pedidos com flock na mão (USERS/.lock, lock do
+// utilizador): um fork() nesse momento deixava o filho com o lock até
+// sair, e o próximo pedido que o quisesse bloqueava para sempre. Cada
+// shard trata os datagramas com o rwlock em leitura e o fork (modos
+// fork/prefork) espera com ele em escrita, como o expiry com g_work_mu.
+// Preferência à escrita: com UDP contínuo o fork não fica à espera.
+static pthread_rwlock_t g_shard_rw;
+static std::vector<int> g_shard_fds;
+
+static void shard_atfork_prepare() { ::pthread_rwlock_wrlock(&g_shard_rw); }
+static void shard_atfork_release() { ::pthread_rwlock_unlock(&g_shard_rw); }
+
+void udp_shards_start(const std::vector<int> &fds, bool verbose)
+{
+    pthread_rwlockattr_t attr;
+    ::pthread_rwlockattr_init(&attr);
+    ::pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    ::pthread_rwlock_init(&g_shard_rw, &attr);
+    ::pthread_rwlockattr_destroy(&attr);
+    ::pthread_atfork(shard_atfork_prepare, shard_atfork_release, shard_atfork_release);
+
+    g_shard_fds = fds;
+
+    for (int fd : fds) {
+        std::thread([fd, verbose] {
+            struct pollfd pfd{fd, POLLIN, 0};
+            while (true) {
+                // esperar fora do lock: só este shard lê deste socket
+                if (::poll(&pfd, 1, -1) <= 0) continue;
+
+                ::pthread_rwlock_rdlock(&g_shard_rw);
+                udp_handle_ready(fd, verbose);
+                ::pthread_rwlock_unlock(&g_shard_rw);
+            }
+        }).detach();
+    }
+}
+
+void udp_shards_close()
+{
+    for (int fd : g_shard_fds) ::close(fd);
+    g_shard_fds.clear();
+}
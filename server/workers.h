@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Em prefork_run/threads_run, udp_fd < 0 significa que o UDP é tratado
+// pelos shards (udp_shards_start) e não pelo loop principal.
+
+// Pool de processos pré-criados: cada filho faz accept() no socket de
+// escuta partilhado e trata as ligações; o pai trata UDP e volta a
+// criar filhos que morram. Só retorna em erro fatal.
+int prefork_run(int listen_fd, int udp_fd, std::size_t nworkers, bool verbose);
+
+// Termina os filhos do pool (seguro para chamar num signal handler).
+void prefork_shutdown();
+
+// Pool de threads: a thread principal faz accept()/recvfrom() e entrega
+// o trabalho (TCP e UDP) a nthreads threads com uma fila de queue_max.
+// Só retorna em erro fatal.
+int threads_run(int listen_fd, int udp_fd, std::size_t nthreads,
+                std::size_t queue_max, bool verbose);
+
+// Uma thread por socket UDP (SO_REUSEPORT) a correr udp_handle_ready.
+// fork() espera que nenhum shard esteja a meio de um pedido (pthread_atfork).
+void udp_shards_start(const std::vector<int> &fds, bool verbose);
+
+// Num filho (fork/prefork): fecha os sockets dos shards, que são do pai.
+void udp_shards_close();
@@ -0,0 +1,215 @@
+// tools/bench_datetime.cpp
+// Microbenchmark das datas do protocolo: o caminho antigo (sscanf +
+// std::tm + mktime, localtime_r + strftime) contra server/datetime
+// (campos lidos no sítio + dt_days_from_civil + cache de offsets).
+// Também conta as diferenças entre os dois, para não medir algo errado
+// (a hora repetida no fim da hora de verão pode dar diferente).
+//
+// Duas amostras: 10 dias (cabem na cache de 256 horas, como as datas que
+// o servidor vê: agora e eventos próximos) e 100 anos (a cache falha
+// quase sempre e o fuso vem de localtime_r, como no caminho antigo).
+//
+// Uso: bench_datetime [iterações]   (TZ=... para outro fuso)
+
+#include "datetime.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+static const std::size_t SAMPLES = 4096;
+
+// acumula resultados para o compilador não apagar o trabalho
+static volatile std::int64_t g_sink = 0;
+
+template <class F>
+static double ns_per_op(std::size_t iters, F &&f)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    std::int64_t acc = 0;
+    for (std::size_t i = 0; i < iters; ++i) acc += f(i % SAMPLES);
+    const auto t1 = std::chrono::steady_clock::now();
+    g_sink = g_sink + acc;
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(iters);
+}
+
+static void report(const char *what, double old_ns, double new_ns, std::size_t diffs)
+{
+    std::printf("%-28s old %8.1f ns/op   new %8.1f ns/op   x%5.1f   diffs %zu\n",
+                what, old_ns, new_ns, old_ns / new_ns, diffs);
+}
+
+// --- caminho antigo (como estava em events.cpp / protocol.cpp) ---
+
+static std::time_t old_parse_event(const std::string &s)
+{
+    int d = 0, m = 0, y = 0, H = 0, M = 0;
+    if (std::sscanf(s.c_str(), "%2d-%2d-%4d %2d:%2d", &d, &m, &y, &H, &M) != 5) return 0;
+    std::tm tm{};
+    tm.tm_mday = d;
+    tm.tm_mon  = m - 1;
+    tm.tm_year = y - 1900;
+    tm.tm_hour = H;
+    tm.tm_min  = M;
+    tm.tm_isdst = -1;
+    return std::mktime(&tm);
+}
+
+static std::time_t old_parse_seconds(const std::string &s)
+{
+    int d = 0, m = 0, y = 0, H = 0, M = 0, S = 0;
+    if (std::sscanf(s.c_str(), "%2d-%2d-%4d %2d:%2d:%2d", &d, &m, &y, &H, &M, &S) != 6) return 0;
+    std::tm tm{};
+    tm.tm_mday = d;
+    tm.tm_mon  = m - 1;
+    tm.tm_year = y - 1900;
+    tm.tm_hour = H;
+    tm.tm_min  = M;
+    tm.tm_sec  = S;
+    tm.tm_isdst = -1;
+    return std::mktime(&tm);
+}
+
+static void old_format(std::time_t t, const char *fmt, char *buf, std::size_t n)
+{
+    std::tm lt{};
+    ::localtime_r(&t, &lt);
+    std::strftime(buf, n, fmt, &lt);
+}
+
+static void run(const char *label, std::time_t first, std::uint64_t span, std::size_t iters)
+{
+    std::printf("-- %s\n", label);
+
+    // instantes espalhados por [first, first + span), em texto nos dois formatos
+    std::vector<std::time_t> ts(SAMPLES);
+    std::vector<std::string> ev(SAMPLES), sec(SAMPLES);
+    std::vector<int> ymd(3 * SAMPLES);
+    std::uint64_t x = 88172645463325252ULL;
+    for (std::size_t i = 0; i < SAMPLES; ++i) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        ts[i] = first + static_cast<std::time_t>(x % span);
+
+        char buf[32];
+        old_format(ts[i], "%d-%m-%Y %H:%M", buf, sizeof(buf));
+        ev[i] = buf;
+        old_format(ts[i], "%d-%m-%Y %H:%M:%S", buf, sizeof(buf));
+        sec[i] = buf;
+
+        std::tm g{};
+        ::gmtime_r(&ts[i], &g);
+        ymd[3 * i]     = g.tm_year + 1900;
+        ymd[3 * i + 1] = g.tm_mon + 1;
+        ymd[3 * i + 2] = g.tm_mday;
+    }
+
+    std::size_t diffs = 0;
+    for (std::size_t i = 0; i < SAMPLES; ++i) {
+        std::time_t t = 0;
+        if (!dt_parse_event(ev[i], t) || t != old_parse_event(ev[i])) ++diffs;
+    }
+    report("parse dd-mm-yyyy hh:mm",
+           ns_per_op(iters, [&](std::size_t i) { return old_parse_event(ev[i]); }),
+           ns_per_op(iters, [&](std::size_t i) {
+               std::time_t t = 0;
+               dt_parse_event(ev[i], t);
+               return t;
+           }),
+           diffs);
+
+    diffs = 0;
+    for (std::size_t i = 0; i < SAMPLES; ++i) {
+        std::time_t t = 0;
+        if (!dt_parse_seconds(sec[i], t) || t != old_parse_seconds(sec[i])) ++diffs;
+    }
+    report("parse dd-mm-yyyy hh:mm:ss",
+           ns_per_op(iters, [&](std::size_t i) { return old_parse_seconds(sec[i]); }),
+           ns_per_op(iters, [&](std::size_t i) {
+               std::time_t t = 0;
+               dt_parse_seconds(sec[i], t);
+               return t;
+           }),
+           diffs);
+
+    diffs = 0;
+    for (std::size_t i = 0; i < SAMPLES; ++i) {
+        char a[32], b[DT_SECONDS_LEN + 1];
+        old_format(ts[i], "%d-%m-%Y %H:%M:%S", a, sizeof(a));
+        dt_format_seconds(ts[i], b);
+        if (std::strcmp(a, b) != 0) ++diffs;
+    }
+    report("format dd-mm-yyyy hh:mm:ss",
+           ns_per_op(iters, [&](std::size_t i) {
+               char buf[32];
+               old_format(ts[i], "%d-%m-%Y %H:%M:%S", buf, sizeof(buf));
+               return static_cast<std::int64_t>(buf[0]);
+           }),
+           ns_per_op(iters, [&](std::size_t i) {
+               char buf[DT_SECONDS_LEN + 1];
+               dt_format_seconds(ts[i], buf);
+               return static_cast<std::int64_t>(buf[0]);
+           }),
+           diffs);
+
+    diffs = 0;
+    for (std::size_t i = 0; i < SAMPLES; ++i) {
+        char a[32], b[DT_FILE_LEN + 1];
+        old_format(ts[i], "%Y-%m-%d %H%M%S", a, sizeof(a));
+        dt_format_file(ts[i], b);
+        if (std::strcmp(a, b) != 0) ++diffs;
+    }
+    report("format yyyy-mm-dd hhmmss",
+           ns_per_op(iters, [&](std::size_t i) {
+               char buf[32];
+               old_format(ts[i], "%Y-%m-%d %H%M%S", buf, sizeof(buf));
+               return static_cast<std::int64_t>(buf[0]);
+           }),
+           ns_per_op(iters, [&](std::size_t i) {
+               char buf[DT_FILE_LEN + 1];
+               dt_format_file(ts[i], buf);
+               return static_cast<std::int64_t>(buf[0]);
+           }),
+           diffs);
+
+    // só o calendário: timegm (UTC, sem fuso) contra a aritmética
+    diffs = 0;
+    for (std::size_t i = 0; i < SAMPLES; ++i) {
+        std::tm tm{};
+        tm.tm_year = ymd[3 * i] - 1900;
+        tm.tm_mon  = ymd[3 * i + 1] - 1;
+        tm.tm_mday = ymd[3 * i + 2];
+        if (::timegm(&tm) / 86400 !=
+            dt_days_from_civil(ymd[3 * i], static_cast<unsigned>(ymd[3 * i + 1]),
+                               static_cast<unsigned>(ymd[3 * i + 2]))) {
+            ++diffs;
+        }
+    }
+    report("civil -> days",
+           ns_per_op(iters, [&](std::size_t i) {
+               std::tm tm{};
+               tm.tm_year = ymd[3 * i] - 1900;
+               tm.tm_mon  = ymd[3 * i + 1] - 1;
+               tm.tm_mday = ymd[3 * i + 2];
+               return static_cast<std::int64_t>(::timegm(&tm) / 86400);
+           }),
+           ns_per_op(iters, [&](std::size_t i) {
+               return dt_days_from_civil(ymd[3 * i], static_cast<unsigned>(ymd[3 * i + 1]),
+                                         static_cast<unsigned>(ymd[3 * i + 2]));
+           }),
+           diffs);
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t iters = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    ::tzset();
+
+    run("10 dias (2030)", 1893456000, 10ULL * 86400, iters);
+    run("100 anos (2000..2100)", 946684800, 100ULL * 365 * 86400, iters);
+    return 0;
+}
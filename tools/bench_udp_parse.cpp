@@ -0,0 +1,146 @@
+// tools/bench_udp_parse.cpp
+// Pacotes/s do parse UDP: o caminho antigo (cópia do datagrama para
+// std::string, istringstream, tokens em strings novas, resposta com
+// operator+) contra o actual (udp_tokenize sobre o buffer, cmd_lookup,
+// validação em string_view e resposta num buffer reutilizado).
+//
+// Só a parte de protocolo: o es_user_* de cada handler (ficheiros ou
+// WAL) é trocado por um estado fixo, igual nos dois caminhos. As
+// respostas dos dois são comparadas antes de medir.
+//
+// Uso: bench_udp_parse [pacotes]
+
+#include "commands.h"
+#include "protocol.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+// mistura de pedidos válidos e mal formados
+static const char *const PACKETS[] = {
+    "LIN 123456 abcd1234\n",
+    "LOU 123456 abcd1234\n",
+    "LME 123456 abcd1234\n",
+    "LMR 123456 abcd1234\n",
+    "UNR 123456 abcd1234\n",
+    "LIN 123456 abcd1234\n",
+    "LMR 654321 Zz9Zz9Zz\n",
+    "LIN 12345 abcd1234\n",
+    "LOU 123456 abcd1234 extra\n",
+    "XYZ 123456 abcd1234\n",
+};
+static const std::size_t NPACKETS = sizeof(PACKETS) / sizeof(PACKETS[0]);
+
+static volatile std::size_t g_sink = 0;
+
+// --- caminho antigo (como estava em udp_handler.cpp) ---
+
+static void old_handle(std::istringstream &iss, const char *tag, std::string &reply)
+{
+    std::string uid, pass, extra;
+    if (!(iss >> uid >> pass) || (iss >> extra) ||
+        !proto_valid_uid(uid) || !proto_valid_password(pass)) {
+        reply = std::string(tag) + " ERR\n";
+        return;
+    }
+
+    std::string status = "OK";
+    reply = std::string(tag) + " " + status + "\n";
+}
+
+static void old_process(const char *buf, std::size_t n, std::string &reply)
+{
+    std::string line(buf, n);
+    std::istringstream iss(line);
+    std::string cmd;
+    iss >> cmd;
+
+    if (cmd == "LIN") {
+        old_handle(iss, "RLI", reply);
+    } else if (cmd == "LOU") {
+        old_handle(iss, "RLO", reply);
+    } else if (cmd == "UNR") {
+        old_handle(iss, "RUR", reply);
+    } else if (cmd == "LME") {
+        old_handle(iss, "RME", reply);
+    } else if (cmd == "LMR") {
+        old_handle(iss, "RMR", reply);
+    } else {
+        reply = "ERR\n";
+    }
+}
+
+// --- caminho actual (udp_process_request sem stats nem verbose) ---
+
+static void new_process(const char *buf, std::size_t n, std::string &reply)
+{
+    UdpTokens t;
+    udp_tokenize(buf, n, t);
+    const std::string_view cmd = t.n > 0 ? t.tok[0] : std::string_view();
+
+    reply.clear();
+
+    const CommandInfo *c = cmd_lookup(cmd);
+    if (!c || c->transport != Transport::Udp) {
+        reply += "ERR\n";
+        return;
+    }
+
+    reply += c->reply;
+    if (t.n != static_cast<std::size_t>(1 + c->nargs) ||
+        !proto_valid_uid(t.tok[1]) || !proto_valid_password(t.tok[2])) {
+        reply += " ERR\n";
+        return;
+    }
+
+    // os handlers só passam a std::string na fronteira com es_user_*
+    const std::string uid(t.tok[1]), pass(t.tok[2]);
+    g_sink = g_sink + uid.size() + pass.size();
+    reply += " OK\n";
+}
+
+template <class F>
+static double packets_per_sec(std::size_t packets, F &&process)
+{
+    std::size_t lens[NPACKETS];
+    for (std::size_t i = 0; i < NPACKETS; ++i) lens[i] = std::strlen(PACKETS[i]);
+
+    std::string reply;
+    std::size_t acc = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < packets; ++i) {
+        const std::size_t k = i % NPACKETS;
+        process(PACKETS[k], lens[k], reply);
+        acc += reply.size();
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    g_sink = g_sink + acc;
+    return static_cast<double>(packets) / std::chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t packets = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+
+    std::size_t diffs = 0;
+    for (std::size_t i = 0; i < NPACKETS; ++i) {
+        std::string a, b;
+        old_process(PACKETS[i], std::strlen(PACKETS[i]), a);
+        new_process(PACKETS[i], std::strlen(PACKETS[i]), b);
+        if (a != b) {
+            std::printf("differs: %s  old %s  new %s", PACKETS[i], a.c_str(), b.c_str());
+            ++diffs;
+        }
+    }
+
+    const double old_pps = packets_per_sec(packets, old_process);
+    const double new_pps = packets_per_sec(packets, new_process);
+    std::printf("udp parse  old %6.2f Mpkt/s (%6.1f ns)   new %6.2f Mpkt/s (%6.1f ns)   x%5.1f   diffs %zu\n",
+                old_pps / 1e6, 1e9 / old_pps, new_pps / 1e6, 1e9 / new_pps,
+                new_pps / old_pps, diffs);
+    return diffs == 0 ? 0 : 1;
+}
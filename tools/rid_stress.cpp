@@ -0,0 +1,207 @@
+// tools/rid_stress.cpp
+// Teste de contenção das reservas (lock por evento): arranca um ES numa
+// diretoria temporária, cria um evento e lança vários processos a fazer
+// RID em simultâneo contra ele. No fim confirma que
+//   - os lugares aceites (RRI ACC) não passam da lotação;
+//   - o nº de reservados que o ES guarda (campo do RSE) é igual aos aceites.
+//
+// Uso: rid_stress <ES> <porto> [args do ES...]   (ex.: -c prefork)
+// Sai com 0 se tudo bater certo.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const int CAPACITY = 50;
+static const int CLIENTS  = 32;
+static const int RIDS_PER_CLIENT = 20;
+
+static const char *const UID  = "100001";
+static const char *const PASS = "password";
+
+static std::uint16_t g_port = 0;
+
+static struct sockaddr_in server_addr()
+{
+    struct sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_port   = htons(g_port);
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return a;
+}
+
+// Um pedido TCP (uma ligação): devolve a resposta toda até o ES fechar.
+static bool tcp_request(const std::string &req, std::string &reply)
+{
+    reply.clear();
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+
+    struct sockaddr_in a = server_addr();
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&a), sizeof(a)) < 0) {
+        ::close(fd);
+        return false;
+    }
+
+    std::size_t done = 0;
+    while (done < req.size()) {
+        ssize_t w = ::write(fd, req.data() + done, req.size() - done);
+        if (w <= 0) { ::close(fd); return false; }
+        done += static_cast<std::size_t>(w);
+    }
+
+    char buf[4096];
+    ssize_t r;
+    while ((r = ::read(fd, buf, sizeof(buf))) > 0) {
+        reply.append(buf, static_cast<std::size_t>(r));
+    }
+    ::close(fd);
+    return !reply.empty();
+}
+
+static bool udp_request(const std::string &req, std::string &reply)
+{
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return false;
+
+    struct timeval tv{3, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    struct sockaddr_in a = server_addr();
+    ::sendto(fd, req.data(), req.size(), 0, reinterpret_cast<struct sockaddr*>(&a), sizeof(a));
+
+    char buf[512];
+    ssize_t r = ::recv(fd, buf, sizeof(buf), 0);
+    ::close(fd);
+    if (r <= 0) return false;
+    reply.assign(buf, static_cast<std::size_t>(r));
+    return true;
+}
+
+static pid_t start_server(char **server_argv, const char *dir)
+{
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        if (::chdir(dir) != 0) std::_Exit(127);
+        if (!std::freopen("/dev/null", "w", stdout)) std::_Exit(127);
+        ::execv(server_argv[0], server_argv);
+        std::_Exit(127);
+    }
+
+    // espera que o porto TCP aceite ligações
+    for (int i = 0; i < 100; ++i) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in a = server_addr();
+        const bool up = ::connect(fd, reinterpret_cast<struct sockaddr*>(&a), sizeof(a)) == 0;
+        ::close(fd);
+        if (up) return pid;
+        ::usleep(50 * 1000);
+    }
+    ::kill(pid, SIGKILL);
+    return -1;
+}
+
+// Um cliente: RIDS_PER_CLIENT reservas de 1..3 lugares; escreve no pipe
+// quantos lugares foram aceites.
+[[noreturn]] static void client(int id, const std::string &eid, int out_fd)
+{
+    int accepted = 0;
+    for (int i = 0; i < RIDS_PER_CLIENT; ++i) {
+        const int seats = 1 + (id + i) % 3;
+        std::string reply;
+        const std::string req = std::string("RID ") + UID + " " + PASS + " " + eid +
+                                " " + std::to_string(seats) + "\n";
+        if (tcp_request(req, reply) && reply == "RRI ACC\n") accepted += seats;
+    }
+    if (::write(out_fd, &accepted, sizeof(accepted)) != sizeof(accepted)) std::_Exit(1);
+    std::_Exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s ES port [ES args...]\n", argv[0]);
+        return 2;
+    }
+    g_port = static_cast<std::uint16_t>(std::atoi(argv[2]));
+
+    char dir[] = "/tmp/rid_stress.XXXXXX";
+    if (!::mkdtemp(dir)) { std::perror("mkdtemp"); return 2; }
+
+    char es_path[4096];
+    if (!::realpath(argv[1], es_path)) { std::perror(argv[1]); return 2; }
+
+    std::vector<char*> sargv;
+    std::string port_s = argv[2];
+    sargv.push_back(es_path);
+    sargv.push_back(const_cast<char*>("-p"));
+    sargv.push_back(&port_s[0]);
+    for (int i = 3; i < argc; ++i) sargv.push_back(argv[i]);
+    sargv.push_back(nullptr);
+
+    pid_t server = start_server(sargv.data(), dir);
+    if (server < 0) { std::fprintf(stderr, "ES did not start\n"); return 2; }
+
+    int status = 1;
+    std::string reply;
+    std::string eid;
+
+    if (!udp_request(std::string("LIN ") + UID + " " + PASS + "\n", reply) ||
+        !tcp_request(std::string("CRE ") + UID + " " + PASS + " stress 01-01-2099 20:00 " +
+                     std::to_string(CAPACITY) + " a.txt 1 a\n", reply) ||
+        reply.compare(0, 7, "RCE OK ") != 0) {
+        std::fprintf(stderr, "setup failed: %s", reply.c_str());
+    } else {
+        eid = reply.substr(7, 3);
+
+        int fds[2];
+        if (::pipe(fds) != 0) { std::perror("pipe"); return 2; }
+        std::vector<pid_t> clients;
+        for (int c = 0; c < CLIENTS; ++c) {
+            pid_t pid = ::fork();
+            if (pid == 0) {
+                ::close(fds[0]);
+                client(c, eid, fds[1]);
+            }
+            if (pid > 0) clients.push_back(pid);
+        }
+        ::close(fds[1]);
+
+        int accepted = 0, n = 0, v;
+        while (::read(fds[0], &v, sizeof(v)) == sizeof(v)) { accepted += v; ++n; }
+        ::close(fds[0]);
+        for (pid_t pid : clients) ::waitpid(pid, nullptr, 0);
+
+        // RSE OK uid name date time attendance reserved Fname Fsize Fdata
+        int reserved = -1;
+        if (tcp_request("SED " + eid + "\n", reply)) {
+            char name[32], date[16], time[16];
+            int att = 0;
+            char uid[16];
+            std::sscanf(reply.c_str(), "RSE OK %15s %31s %15s %15s %d %d",
+                        uid, name, date, time, &att, &reserved);
+        }
+
+        std::printf("clients=%d/%d accepted=%d reserved=%d capacity=%d\n",
+                    n, CLIENTS, accepted, reserved, CAPACITY);
+        if (n == CLIENTS && accepted <= CAPACITY && reserved == accepted) {
+            status = 0;
+        } else {
+            std::printf("FAIL (dados do ES em %s)\n", dir);
+        }
+    }
+
+    ::kill(server, SIGTERM);
+    ::waitpid(server, nullptr, 0);
+    if (status == 0) std::system((std::string("rm -rf ") + dir).c_str());
+    return status;
+}
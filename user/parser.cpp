@@ -7,52 +7,47 @@
 #include "udp_handler.h"
 #include "tcp_handler.h"
 
-// palavra - comando
-UserCommandType command_from_word(const char *word) {
-    if (strcmp(word, "login") == 0)           return CMD_LOGIN;
-    if (strcmp(word, "logout") == 0)          return CMD_LOGOUT;
-    if (strcmp(word, "unregister") == 0)      return CMD_UNREGISTER;
-    if (strcmp(word, "myevents") == 0 ||
-        strcmp(word, "mye") == 0)             return CMD_MYEVENTS;
-    if (strcmp(word, "myres") == 0 ||
-        strcmp(word, "myr") == 0 ||
-        strcmp(word, "myreservations") == 0)  return CMD_MYRES;
-    if (strcmp(word, "create") == 0)          return CMD_CREATE;
-    if (strcmp(word, "close") == 0)           return CMD_CLOSE;
-    if (strcmp(word, "list") == 0)            return CMD_LIST;
-    if (strcmp(word, "show") == 0)            return CMD_SHOW;
-    if (strcmp(word, "reserve") == 0)         return CMD_RESERVE;
-    if (strcmp(word, "changepw") == 0 ||
-        strcmp(word, "changePass") == 0)      return CMD_CHANGEPASS;
+// palavra - comando - protocolo (uma linha por palavra aceite)
+static const struct {
+    const char      *word;
+    UserCommandType  cmd;
+    ProtocolKind     proto;
+} USER_COMMANDS[] = {
+    /* UDP  */
+    {"login",          CMD_LOGIN,      PROTO_UDP},
+    {"logout",         CMD_LOGOUT,     PROTO_UDP},
+    {"unregister",     CMD_UNREGISTER, PROTO_UDP},
+    {"myevents",       CMD_MYEVENTS,   PROTO_UDP},
+    {"mye",            CMD_MYEVENTS,   PROTO_UDP},
+    {"myres",          CMD_MYRES,      PROTO_UDP},
+    {"myr",            CMD_MYRES,      PROTO_UDP},
+    {"myreservations", CMD_MYRES,      PROTO_UDP},
+
+    /* TCP  */
+    {"create",         CMD_CREATE,     PROTO_TCP},
+    {"close",          CMD_CLOSE,      PROTO_TCP},
+    {"list",           CMD_LIST,       PROTO_TCP},
+    {"search",         CMD_SEARCH,     PROTO_TCP},
+    {"show",           CMD_SHOW,       PROTO_TCP},
+    {"reserve",        CMD_RESERVE,    PROTO_TCP},
+    {"changepw",       CMD_CHANGEPASS, PROTO_TCP},
+    {"changePass",     CMD_CHANGEPASS, PROTO_TCP},
+};
 
+UserCommandType command_from_word(const char *word) {
+    for (const auto &c : USER_COMMANDS) {
+        if (strcmp(word, c.word) == 0) return c.cmd;
+    }
     return CMD_INVALID;
 }
 
 
 // Comando - tipo de protocolo
 ProtocolKind command_protocol(UserCommandType cmd) {
-    switch (cmd) {
-        /* UDP  */
-        case CMD_LOGIN:
-        case CMD_LOGOUT:
-        case CMD_UNREGISTER:
-        case CMD_MYEVENTS:
-        case CMD_MYRES:
-            return PROTO_UDP;
-
-        /* TCP  */
-        case CMD_CREATE:
-        case CMD_CLOSE:
-        case CMD_LIST:
-        case CMD_SHOW:
-        case CMD_RESERVE:
-        case CMD_CHANGEPASS:
-            return PROTO_TCP;
-
-        case CMD_INVALID:
-        default:
-            return PROTO_INVALID;
+    for (const auto &c : USER_COMMANDS) {
+        if (c.cmd == cmd) return c.proto;
     }
+    return PROTO_INVALID;
 }
 
 
@@ -60,6 +55,7 @@ void parse_args(ClientNetConfig *cfg, int argc, char **argv) {
     /* valores por omissão */
     strcpy(cfg->server_ip, "127.0.0.1"); // ES na mesma máquina
     cfg->server_port = 58000 + GN ;      
+    cfg->keep_alive  = 0;
 
     for (int i = 1; i < argc; i++) {
         if (!strcmp(argv[i], "-n") && i + 1 < argc) {
@@ -67,8 +63,10 @@ void parse_args(ClientNetConfig *cfg, int argc, char **argv) {
             cfg->server_ip[sizeof(cfg->server_ip) - 1] = '\0';
         } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
             cfg->server_port = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-k")) {
+            cfg->keep_alive = 1;
         } else {
-            fprintf(stderr, "Usage: %s [-n ESIP] [-p ESport]\n", argv[0]);
+            fprintf(stderr, "Usage: %s [-n ESIP] [-p ESport] [-k]\n", argv[0]);
             exit(1);
         }
     }
@@ -20,6 +20,7 @@ typedef enum {
     CMD_SHOW,
     CMD_RESERVE,
     CMD_CHANGEPASS,
+    CMD_SEARCH,
     CMD_INVALID
 } UserCommandType;
 
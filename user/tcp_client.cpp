@@ -1,5 +1,6 @@
 #include "tcp_client.h"
 
+#include <cerrno>
 #include <cstring>
 #include <string>
 #include <stdexcept>
@@ -44,6 +45,53 @@ int tcp_connect(const ClientNetConfig *cfg)
     return fd;
 }
 
+// ligação persistente (-k)
+static int  g_kal_fd = -1;
+static bool g_kal_unsupported = false;
+
+int tcp_acquire(const ClientNetConfig *cfg)
+{
+    if (!cfg->keep_alive || g_kal_unsupported) {
+        return tcp_connect(cfg);
+    }
+
+    if (g_kal_fd >= 0) {
+        // o ES pode ter fechado entretanto (ERR, timeout de inactividade)
+        char c;
+        ssize_t n = ::recv(g_kal_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return g_kal_fd;
+        }
+        ::close(g_kal_fd);
+        g_kal_fd = -1;
+    }
+
+    int fd = tcp_connect(cfg);
+    const char kal[] = "KAL\n";
+    if (tcp_send_all(fd, kal, sizeof(kal) - 1) == 0 &&
+        tcp_recv_line(fd) == "RKA OK\n") {
+        g_kal_fd = fd;
+        return fd;
+    }
+
+    // ES antigo (ERR e fecha) ou modo sem KAL (RKA NOK, prefork/threads)
+    ::close(fd);
+    g_kal_unsupported = true;
+    return tcp_connect(cfg);
+}
+
+void tcp_release(int fd)
+{
+    if (fd == g_kal_fd) return;
+    ::close(fd);
+}
+
+void tcp_close(int fd)
+{
+    if (fd == g_kal_fd) g_kal_fd = -1;
+    ::close(fd);
+}
+
 int tcp_send_all(int fd, const void *buf, size_t len)
 {
     const char *ptr = static_cast<const char*>(buf);
@@ -60,20 +108,29 @@ int tcp_send_all(int fd, const void *buf, size_t len)
     return 0; // sucesso
 }
 
-// lê até '\n' (ou EOF), devolve std::string
+// lê até '\n' (ou EOF), devolve std::string.
+// Espreita (MSG_PEEK) o que já chegou e consome só até ao '\n': um recv
+// por bloco em vez de um read por byte, sem tirar do socket bytes que
+// são da resposta seguinte (Fdata do RSE, próximo comando com KAL).
 std::string tcp_recv_line(int fd)
 {
     std::string line;
-    char c;
-    ssize_t n;
+    char buf[4096];
 
     while (true) {
-        n = ::read(fd, &c, 1);
+        ssize_t n = ::recv(fd, buf, sizeof(buf), MSG_PEEK);
         if (n <= 0) {
             break;  // erro ou ligação fechada
         }
-        line.push_back(c);
-        if (c == '\n') {
+        const char *nl = static_cast<const char*>(std::memchr(buf, '\n', n));
+        const size_t take = nl ? static_cast<size_t>(nl - buf) + 1 : static_cast<size_t>(n);
+
+        n = ::read(fd, buf, take);
+        if (n <= 0) {
+            break;
+        }
+        line.append(buf, static_cast<size_t>(n));
+        if (nl && static_cast<size_t>(n) == take) {
             break;
         }
     }
@@ -7,6 +7,17 @@
 // abre um socket TCP ligado ao ES (usa cfg->server_ip e cfg->server_port)
 int tcp_connect(const ClientNetConfig *cfg);
 
+// ligação para um comando TCP. Com cfg->keep_alive, negoceia "KAL" com o
+// ES e reutiliza a mesma ligação enquanto o ES a mantiver aberta
+// (ES sem suporte -> uma ligação por comando, como antes).
+int tcp_acquire(const ClientNetConfig *cfg);
+
+// resposta lida por completo: a ligação pode servir o próximo comando
+void tcp_release(int fd);
+
+// erro a meio de um comando: fecha (e esquece a ligação persistente)
+void tcp_close(int fd);
+
 // envia todos os 'len' bytes (repetindo write se for preciso)
 int tcp_send_all(int fd, const void *buf, size_t len);
 
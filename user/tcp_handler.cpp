@@ -28,6 +28,40 @@ static bool tcp_recv_exact(int fd, void *buf, size_t len)
 }
 
 
+// Lê o cabeçalho de RSE: a linha toda se o status não for OK, senão
+// os 8 campos seguintes, parando no espaço depois de Fsize.
+static std::string tcp_recv_rse_header(int fd)
+{
+    std::string header;
+    int spaces = 0;
+    char c;
+
+    while (tcp_recv_exact(fd, &c, 1)) {
+        header.push_back(c);
+        if (c == '\n') break;                       // RSE NOK / RSE ERR
+        if (c != ' ') continue;
+
+        ++spaces;
+        if (spaces == 2 && header != "RSE OK ") {
+            return header + tcp_recv_line(fd);      // resto da linha
+        }
+        if (spaces == 10) break;                    // espaço depois de Fsize
+    }
+    return header;
+}
+
+
+// Estado do evento em texto (list e search)
+static std::string state_text_of(const std::string &state_str)
+{
+    if (state_str == "0") return "Past";
+    if (state_str == "1") return "Open";
+    if (state_str == "2") return "Sold out";
+    if (state_str == "3") return "Closed";
+    return "Unknown";
+}
+
+
 static void handle_list(ClientState *,
                         const ClientNetConfig *cfg,
                         const char *line)
@@ -47,19 +81,19 @@ static void handle_list(ClientState *,
 
     try {
         // 2) abrir ligação TCP
-        fd = tcp_connect(cfg);
+        fd = tcp_acquire(cfg);
 
         // 3) enviar "LST\n"
         std::string request = "LST\n";
         if (tcp_send_all(fd, request.data(), request.size()) < 0) {
             std::cerr << "Error sending LST request.\n";
-            ::close(fd);
+            tcp_close(fd);
             return;
         }
 
         // 4) ler uma linha de resposta
         std::string response = tcp_recv_line(fd);
-        ::close(fd);
+        tcp_release(fd);
         fd = -1;
 
         if (response.empty()) {
@@ -96,26 +130,10 @@ static void handle_list(ClientState *,
         int count = 0;
 
         while (iss >> eid >> name >> state_str >> date >> time) {
-            int s = -1;
-            try {
-                s = std::stoi(state_str);
-            } catch (...) {
-                s = -1;
-            }
-
-            std::string state_text;
-            switch (s) {
-                case 0: state_text = "Past";     break;
-                case 1: state_text = "Open";     break;
-                case 2: state_text = "Sold out"; break;
-                case 3: state_text = "Closed";   break;
-                default: state_text = "Unknown"; break;
-            }
-
             std::cout << "  Event " << eid
                       << " [" << name << "] on " << date
                       << " at " << time
-                      << " -> " << state_text << "\n";
+                      << " -> " << state_text_of(state_str) << "\n";
 
             ++count;
         }
@@ -125,12 +143,136 @@ static void handle_list(ClientState *,
         }
 
     } catch (const std::exception &e) {
-        if (fd >= 0) ::close(fd);
+        if (fd >= 0) tcp_close(fd);
         std::cerr << "LIST TCP error: " << e.what() << "\n";
     }
 }
 
 
+// search [open] [soldout] [past] [closed] [from=dd-mm-yyyy] [to=dd-mm-yyyy]
+//        [name=prefixo] [mine | owner=UID] [page=N] [after=EID]
+// Pede ao ES uma página filtrada (LSX) em vez da lista toda.
+static void handle_search(ClientState *state,
+                          const ClientNetConfig *cfg,
+                          const char *line)
+{
+    const char *usage =
+        "Usage: search [open] [soldout] [past] [closed] [from=dd-mm-yyyy] "
+        "[to=dd-mm-yyyy] [name=prefix] [mine|owner=UID] [page=N] [after=EID]\n";
+
+    // 1) opções -> campos do LSX ("-" = qualquer)
+    std::string states, from = "-", to = "-", prefix = "-", owner = "-";
+    std::string page = "20", after = "000";
+    {
+        std::istringstream iss(line);
+        std::string cmd, opt;
+        iss >> cmd;
+
+        while (iss >> opt) {
+            const std::size_t eq = opt.find('=');
+            const std::string key = opt.substr(0, eq);
+            const std::string val = eq == std::string::npos ? "" : opt.substr(eq + 1);
+
+            if (opt == "past")          states += '0';
+            else if (opt == "open")     states += '1';
+            else if (opt == "soldout")  states += '2';
+            else if (opt == "closed")   states += '3';
+            else if (opt == "mine") {
+                if (!state->logged_in) {
+                    std::cout << "You need to login first.\n";
+                    return;
+                }
+                owner = state->uid;
+            }
+            else if (key == "from"  && !val.empty()) from   = val;
+            else if (key == "to"    && !val.empty()) to     = val;
+            else if (key == "name"  && !val.empty()) prefix = val;
+            else if (key == "owner" && !val.empty()) owner  = val;
+            else if (key == "page"  && !val.empty()) page   = val;
+            else if (key == "after" && !val.empty()) after  = val;
+            else {
+                std::cerr << usage;
+                return;
+            }
+        }
+    }
+    if (states.empty()) states = "-";
+
+    int fd = -1;
+
+    try {
+        // 2) LSX states from to prefix owner count after
+        fd = tcp_acquire(cfg);
+
+        std::string request = "LSX " + states + " " + from + " " + to + " " +
+                              prefix + " " + owner + " " + page + " " + after + "\n";
+        if (tcp_send_all(fd, request.data(), request.size()) < 0) {
+            std::cerr << "Error sending LSX request.\n";
+            tcp_close(fd);
+            return;
+        }
+
+        std::string response = tcp_recv_line(fd);
+        tcp_release(fd);
+        fd = -1;
+
+        if (response.empty()) {
+            std::cerr << "Empty response to LSX.\n";
+            return;
+        }
+
+        // 3) RLX OK next n [EID name state date time]*
+        std::istringstream iss(response);
+        std::string tag, status;
+        iss >> tag >> status;
+
+        if (tag != "RLX") {
+            std::cerr << "Protocol error on search: expected 'RLX', got '"
+                      << tag << "'\n";
+            return;
+        }
+
+        if (status == "NOK") {
+            std::cout << "No events match.\n";
+            return;
+        }
+
+        if (status == "ERR") {
+            std::cerr << usage;
+            return;
+        }
+
+        if (status != "OK") {
+            std::cout << "Server returned status " << status
+                      << " for search.\n";
+            return;
+        }
+
+        std::string next;
+        int n = 0;
+        iss >> next >> n;
+
+        std::cout << "Events (" << n << " in this page)\n";
+
+        std::string eid, name, state_str, date, time;
+        while (iss >> eid >> name >> state_str >> date >> time) {
+            std::cout << "  Event " << eid
+                      << " [" << name << "] on " << date
+                      << " at " << time
+                      << " -> " << state_text_of(state_str) << "\n";
+        }
+
+        if (next != "000") {
+            std::cout << "More events: repeat with after=" << next << "\n";
+        }
+
+    } catch (const std::exception &e) {
+        if (fd >= 0) tcp_close(fd);
+        std::cerr << "SEARCH TCP error: " << e.what() << "\n";
+    }
+}
+
+
 static void handle_close(ClientState *state,
                          const ClientNetConfig *cfg,
                          const char *line)
@@ -157,7 +299,7 @@ static void handle_close(ClientState *state,
 
     try {
         // 3) abrir ligação TCP ao ES
-        fd = tcp_connect(cfg);
+        fd = tcp_acquire(cfg);
 
         // 4) construir pedido CLS
         std::string request = "CLS " + state->uid + " " + state->pass +
@@ -165,13 +307,13 @@ static void handle_close(ClientState *state,
 
         if (tcp_send_all(fd, request.data(), request.size()) < 0) {
             std::cerr << "Error sending CLS request.\n";
-            ::close(fd);
+            tcp_close(fd);
             return;
         }
 
         // 5) ler 1 linha de resposta
         std::string response = tcp_recv_line(fd);
-        ::close(fd);
+        tcp_release(fd);
         fd = -1;
 
         if (response.empty()) {
@@ -226,7 +368,7 @@ static void handle_close(ClientState *state,
         }
 
     } catch (const std::exception &e) {
-        if (fd >= 0) ::close(fd);
+        if (fd >= 0) tcp_close(fd);
         std::cerr << "CLOSE TCP error: " << e.what() << "\n";
     }
 }
@@ -258,7 +400,7 @@ static void handle_changepass(ClientState *state,
 
     try {
         // abrir TCP
-        fd = tcp_connect(cfg);
+        fd = tcp_acquire(cfg);
 
         // construir pedido CPS
         std::string request = "CPS " + state->uid + " " +
@@ -266,13 +408,13 @@ static void handle_changepass(ClientState *state,
 
         if (tcp_send_all(fd, request.data(), request.size()) < 0) {
             std::cerr << "Error sending CPS request.\n";
-            ::close(fd);
+            tcp_close(fd);
             return;
         }
 
         // ler 1 linha de resposta
         std::string response = tcp_recv_line(fd);
-        ::close(fd);
+        tcp_release(fd);
         fd = -1;
 
         if (response.empty()) {
@@ -313,7 +455,7 @@ static void handle_changepass(ClientState *state,
         }
 
     } catch (const std::exception &e) {
-        if (fd >= 0) ::close(fd);
+        if (fd >= 0) tcp_close(fd);
         std::cerr << "CHANGEPASS TCP error: " << e.what() << "\n";
     }
 }
@@ -357,7 +499,7 @@ static void handle_reserve(ClientState *state,
 
     try {
         // 3) abrir ligação TCP
-        fd = tcp_connect(cfg);
+        fd = tcp_acquire(cfg);
 
         // 4) construir pedido RID
         std::string request = "RID " + state->uid + " " + state->pass +
@@ -365,13 +507,13 @@ static void handle_reserve(ClientState *state,
 
         if (tcp_send_all(fd, request.data(), request.size()) < 0) {
             std::cerr << "Error sending RID request.\n";
-            ::close(fd);
+            tcp_close(fd);
             return;
         }
 
         // 5) ler 1 linha de resposta
         std::string response = tcp_recv_line(fd);
-        ::close(fd);
+        tcp_release(fd);
         fd = -1;
 
         if (response.empty()) {
@@ -440,7 +582,7 @@ static void handle_reserve(ClientState *state,
         }
 
     } catch (const std::exception &e) {
-        if (fd >= 0) ::close(fd);
+        if (fd >= 0) tcp_close(fd);
         std::cerr << "RESERVE TCP error: " << e.what() << "\n";
     }
 }
@@ -514,7 +656,7 @@ static void handle_create(ClientState *state,
 
     try {
         // Abrir ligação TCP
-        fd = tcp_connect(cfg);
+        fd = tcp_acquire(cfg);
 
         // Construir mensagem CRE:
         // CRE UID password name event_date attendance_size Fname Fsize Fdata
@@ -528,28 +670,27 @@ static void handle_create(ClientState *state,
             << attendees << " "
             << fname << " "
             << file_data.size()
-            << "\n";
+            << " ";
 
         std::string header = oss.str();
 
         if (tcp_send_all(fd, header.data(), header.size()) < 0) {
             std::cerr << "Error sending CRE header.\n";
-            ::close(fd);
+            tcp_close(fd);
             return;
         }
 
-        // Enviar Fdata
-        if (!file_data.empty()) {
-            if (tcp_send_all(fd, file_data.data(), file_data.size()) < 0) {
-                std::cerr << "Error sending CRE file data.\n";
-                ::close(fd);
-                return;
-            }
+        // Enviar Fdata + '\n' final
+        file_data.push_back('\n');
+        if (tcp_send_all(fd, file_data.data(), file_data.size()) < 0) {
+            std::cerr << "Error sending CRE file data.\n";
+            tcp_close(fd);
+            return;
         }
 
         // Ler resposta: "RCE status [EID]\n"
         std::string response = tcp_recv_line(fd);
-        ::close(fd);
+        tcp_release(fd);
         fd = -1;
 
         if (response.empty()) {
@@ -582,7 +723,7 @@ static void handle_create(ClientState *state,
         }
 
     } catch (const std::exception &e) {
-        if (fd >= 0) ::close(fd);
+        if (fd >= 0) tcp_close(fd);
         std::cerr << "CREATE TCP error: " << e.what() << "\n";
     }
 }
@@ -606,21 +747,22 @@ static void handle_show(ClientState *,
     int fd = -1;
 
     try {
-        fd = tcp_connect(cfg);
+        fd = tcp_acquire(cfg);
 
         // Enviar "SED EID\n"
         std::string request = "SED " + eid + "\n";
         if (tcp_send_all(fd, request.data(), request.size()) < 0) {
             std::cerr << "Error sending SED request.\n";
-            ::close(fd);
+            tcp_close(fd);
             return;
         }
 
-        // Ler linha de cabeçalho
-        std::string header = tcp_recv_line(fd);
+        // Ler cabeçalho: "RSE status" e, se OK, os campos até Fsize
+        // (terminado por ' ', logo seguido de Fdata)
+        std::string header = tcp_recv_rse_header(fd);
         if (header.empty()) {
             std::cerr << "Empty response to SED.\n";
-            ::close(fd);
+            tcp_close(fd);
             return;
         }
 
@@ -630,7 +772,7 @@ static void handle_show(ClientState *,
 
         if (tag != "RSE" || status.empty()) {
             std::cerr << "Protocol error on show: " << header << "\n";
-            ::close(fd);
+            tcp_close(fd);
             return;
         }
 
@@ -642,7 +784,7 @@ static void handle_show(ClientState *,
             } else {
                 std::cout << "Show failed with status: " << status << "\n";
             }
-            ::close(fd);
+            tcp_close(fd);
             return;
         }
 
@@ -656,7 +798,7 @@ static void handle_show(ClientState *,
         if (!(iss >> owner_uid >> name >> date >> time
                   >> attendance >> reserved >> fname >> fsize_ll)) {
             std::cerr << "Malformed RSE header: " << header << "\n";
-            ::close(fd);
+            tcp_close(fd);
             return;
         }
 
@@ -664,7 +806,7 @@ static void handle_show(ClientState *,
 
         if (fsize_ll < 0 || fsize_ll > 10'000'000) {
             std::cerr << "Invalid file size in RSE: " << fsize_ll << "\n";
-            ::close(fd);
+            tcp_close(fd);
             return;
         }
 
@@ -676,12 +818,20 @@ static void handle_show(ClientState *,
         if (fsize > 0) {
             if (!tcp_recv_exact(fd, file_data.data(), fsize)) {
                 std::cerr << "Error receiving file data in RSE.\n";
-                ::close(fd);
+                tcp_close(fd);
                 return;
             }
         }
 
-        ::close(fd);
+        // '\n' final
+        char endc = 0;
+        if (!tcp_recv_exact(fd, &endc, 1) || endc != '\n') {
+            std::cerr << "Malformed end of RSE.\n";
+            tcp_close(fd);
+            return;
+        }
+
+        tcp_release(fd);
         fd = -1;
 
         // Guardar ficheiro localmente com nome Fname
@@ -721,7 +871,7 @@ static void handle_show(ClientState *,
         }
 
     } catch (const std::exception &e) {
-        if (fd >= 0) ::close(fd);
+        if (fd >= 0) tcp_close(fd);
         std::cerr << "SHOW TCP error: " << e.what() << "\n";
     }
 }
@@ -747,6 +897,8 @@ void tcp_dispatch_command(ClientState *state,
         handle_create(state, cfg, line);  
     } else if (cmd == "show") {
         handle_show(state, cfg, line);    
+    } else if (cmd == "search") {
+        handle_search(state, cfg, line);
     } else {
         std::cerr << "Unknown TCP command: " << cmd << "\n";
     }
@@ -7,6 +7,7 @@
 typedef struct {
     char server_ip[64];  
     int  server_port;   
+    int  keep_alive;     // -k: reutilizar a ligação TCP entre comandos
 } ClientNetConfig;
 
 //Estado lógico do cliente 